@@ -134,3 +134,19 @@ Quaternion Quaternion::slerp(const Quaternion& a, const Quaternion& b, double t)
     return a * (Quaternion(baseAxis, baseAngle * t));
 }
 
+Quaternion Quaternion::nlerp(const Quaternion& a, const Quaternion& b, double t) {
+    double dot = a.x*b.x + a.y*b.y + a.z*b.z + a.w*b.w;
+    double bSign = dot < 0 ? -1. : 1.;
+
+    double s = 1. - t;
+    double k = t * bSign;
+
+    return Quaternion(a.x*s + b.x*k, a.y*s + b.y*k, a.z*s + b.z*k, a.w*s + b.w*k).normalize();
+}
+
+const Placement Placement::interpolate(const Placement& a, const Placement& b, double t, bool useSlerp) {
+    Vec3 p = a.pos + (b.pos - a.pos) * t;
+
+    if (useSlerp) return Placement(p, Quaternion::slerp(a.dir, b.dir, t));
+    return Placement(p, Quaternion::nlerp(a.dir, b.dir, t));
+}
@@ -187,7 +187,21 @@ class Quaternion {
     //Hamilton product
     const Quaternion operator*(const Quaternion& other) const;
 
-    ///todo: const glm::mat4 toMatrix() const;
+    ///x, y, z, w, narrowed to float
+    void toFloats(float* out) const {
+        out[0] = float(x); out[1] = float(y); out[2] = float(z); out[3] = float(w);
+    }
+    ///column-major 4x4 rotation matrix (glm/OpenGL layout), narrowed to float; expects a unit quaternion
+    void toMatrix(float* out) const {
+        double xx = x*x, yy = y*y, zz = z*z;
+        double xy = x*y, xz = x*z, yz = y*z;
+        double wx = w*x, wy = w*y, wz = w*z;
+
+        out[0] = float(1. - 2.*(yy + zz)); out[1] = float(2.*(xy + wz));      out[2] = float(2.*(xz - wy));      out[3] = 0.f;
+        out[4] = float(2.*(xy - wz));      out[5] = float(1. - 2.*(xx + zz)); out[6] = float(2.*(yz + wx));      out[7] = 0.f;
+        out[8] = float(2.*(xz + wy));      out[9] = float(2.*(yz - wx));      out[10] = float(1. - 2.*(xx + yy)); out[11] = 0.f;
+        out[12] = 0.f; out[13] = 0.f; out[14] = 0.f; out[15] = 1.f;
+    }
 
     const Quaternion normalize() const;
     const Quaternion conjugate() const;
@@ -222,6 +236,8 @@ class Quaternion {
 
 
     static Quaternion slerp(const Quaternion& a, const Quaternion& b, double t);
+    ///normalized lerp along the shorter arc; not constant angular velocity, but much cheaper than slerp
+    static Quaternion nlerp(const Quaternion& a, const Quaternion& b, double t);
 
     private:
     double x, y, z, w;
@@ -263,9 +279,18 @@ struct Placement {
     }
 	*/
 
+    ///column-major 4x4 transform (rotate by dir, then translate by pos), narrowed to float
+    void toMatrix(float* out) const {
+        dir.toMatrix(out);
+        out[12] = float(pos.x); out[13] = float(pos.y); out[14] = float(pos.z);
+    }
+
     ///this treated as transform, result is other transformed by this
     const Placement applyAsTransform(const Placement& other) const;
 
+    ///blends position linearly and orientation with nlerp (or slerp, if useSlerp)
+    static const Placement interpolate(const Placement& a, const Placement& b, double t, bool useSlerp = false);
+
     const Placement operator-() const {
         return Placement(-pos, dir.conjugate());
     }
@@ -3,24 +3,33 @@
 
 #include "component.h"
 
+Entity::Entity(EntityID _ID, Placement p)
+    :   ID(_ID), prevDeltaTime(1.), placementHash(0), asleep(false), wakeAt(-1.), awakeIndex(-1), prevPos(p), pos(p) {}
+
+
 Entity::Entity(EntityID _ID, Placement p, const std::vector<std::reference_wrapper<IPartialComponent>>& componentList,
                std::function<SystemBase&(SystemType)> typeToSystem)
-    :   ID(_ID), pos(p), prevPos(p), prevDeltaTime(1.) {
+    :   ID(_ID), prevDeltaTime(1.), placementHash(0), asleep(false), wakeAt(-1.), awakeIndex(-1), prevPos(p), pos(p) {
     for (auto& c : componentList) {
-        relatedSystems.insert(&(c.get())(ID, typeToSystem));
+        addRelatedSystem(&(c.get())(ID, typeToSystem));
     }
 }
 
 
 Entity::Entity(EntityID _ID, Placement p, const std::vector<std::shared_ptr<IPartialComponent>>& componentList,
                std::function<SystemBase&(SystemType)> typeToSystem)
-    :   ID(_ID), pos(p), prevPos(p), prevDeltaTime(1.) {
+    :   ID(_ID), prevDeltaTime(1.), placementHash(0), asleep(false), wakeAt(-1.), awakeIndex(-1), prevPos(p), pos(p) {
     for (auto& c : componentList) {
-        relatedSystems.insert(&(*c)(ID, typeToSystem));
+        addRelatedSystem(&(*c)(ID, typeToSystem));
     }
 }
 
 
+void refreshModuleSlot(Entity& e, SystemType st, void* module) {
+    if ((std::size_t) st < e.moduleCache.size()) e.moduleCache[st].module = module;
+}
+
+
 Entity::~Entity() {
     for (auto& i : relatedSystems) i->destroyEntityModules(this->ID);
 }
@@ -27,17 +27,57 @@ struct SavedEntity {
 
     SavedEntity(EntityID eid, std::vector<std::shared_ptr<IPartialComponent>>&& componentList, Placement p)
         : ID(eid), components(componentList), pos(p) {}
+
+    ///heap bytes held by this save (component list + each shared PartialComponent)
+    std::size_t heapBytes() const {
+        std::size_t out = vectorBytes(components);
+        for (auto& c : components) out += c->footprint() + sharedControlBlockBytes();
+        return out;
+    }
 };
 
 class Entity {
     EntityID ID;
     std::unordered_set<SystemBase*> relatedSystems;
-    Placement prevPos;
     double prevDeltaTime;
 
+    ///Instance pointers indexed by SystemType, for get/tryGet; filled by addRelatedSystem, and refreshed by
+    /// Systems that relocate Instances
+    struct CachedModule {
+        void* module = nullptr;
+        SystemBase* system = nullptr;
+    };
+    std::vector<CachedModule> moduleCache;
+
+    void cacheModule(SystemType st, void* module, SystemBase* sys) {
+        if ((std::size_t) st >= moduleCache.size()) {
+            if (module == nullptr) return;
+            moduleCache.resize(st + 1);
+        }
+        moduleCache[st] = CachedModule{module, sys};
+    }
+
+    friend void refreshModuleSlot(Entity& e, SystemType st, void* module);
+
+    ///this entity's contribution to WorldBase::stateHash, as of the last call
+    std::uint64_t placementHash;
+
+    ///sleep state, managed by WorldBase (see WorldBase::sleep)
+    bool asleep;
+    double wakeAt;
+    int awakeIndex;
+
+    friend class WorldBase;
+
+    ///declared right before pos, so per-frame transform scans (prevPos/pos compares, interpolation, extraction)
+    /// read one contiguous 112 bytes per entity
+    Placement prevPos;
+
     public:
     Placement pos;
 
+    ///no components; systems are attached afterwards through addRelatedSystem
+    Entity(EntityID _ID, Placement p);
     Entity(EntityID _ID, Placement p, const std::vector<std::reference_wrapper<IPartialComponent>>& componentList,
            std::function<SystemBase&(SystemType)> typeToSystem);
     Entity(EntityID _ID, Placement p, const std::vector<std::shared_ptr<IPartialComponent>>& componentList,
@@ -48,6 +88,7 @@ class Entity {
     Entity& operator= (const Entity&) = delete;
 
     EntityID getID() const { return ID; }
+    bool isAsleep() const { return asleep; }
 
     void updatePrevPos(double deltaTime) {
         prevPos = pos;
@@ -58,6 +99,11 @@ class Entity {
         return prevPos;
     }
 
+    ///zeroes the frame velocity; used when an entity goes to sleep
+    void settle() {
+        prevPos = pos;
+    }
+
     Vec3 getFrameVel() const {
         return pos.pos - prevPos.pos;
     }
@@ -78,12 +124,47 @@ class Entity {
 	}
 
 	//needed so connectSystem can keep track of the lifetime of a limb tree parent
-	void addRelatedSystem(SystemBase* b) {
-        relatedSystems.insert(b);
+	///returns false if b was already related; refreshes the module cache either way, since b may have
+	/// destroyed and re-created this entity's module without unrelating it
+	bool addRelatedSystem(SystemBase* b) {
+        bool added = relatedSystems.insert(b).second;
+        cacheModule(b->getType(), b->modulePtr(ID), b);
+        return added;
+	}
+
+	void removeRelatedSystem(SystemBase* b) {
+        relatedSystems.erase(b);
+        cacheModule(b->getType(), nullptr, nullptr);
 	}
 
+    ///this entity's Instance in Sys, with no hashing; nullptr if it has none
+    ///Sys must have one Instance per entity (System, not MultiSystem/TagSystem), and be the System registered for
+    /// Sys::Type in this entity's world; remove modules through WorldBase so the cache stays current
+    template <class Sys>
+    typename Sys::InstanceType* tryGet() {
+        static_assert(Sys::SingleModule, "Entity::get needs a System with one Instance per entity");
+
+        if ((std::size_t) Sys::Type >= moduleCache.size()) return nullptr;
+
+        const CachedModule& c = moduleCache[Sys::Type];
+        assert(c.module == nullptr || dynamic_cast<Sys*>(c.system) != nullptr);
+        return static_cast<typename Sys::InstanceType*>(c.module);
+    }
+
+    template <class Sys>
+    typename Sys::InstanceType& get() {
+        typename Sys::InstanceType* out = tryGet<Sys>();
+        assert(out != nullptr);
+        return *out;
+    }
+
 	SavedEntity save();
 
+    ///heap bytes owned by this Entity, not counting the Entity itself
+    std::size_t heapBytes() const {
+        return hashContainerBytes(relatedSystems) + vectorBytes(moduleCache);
+    }
+
 };
 
 #endif // ACTOR_H
@@ -0,0 +1,37 @@
+#include "examplegame.h"
+#include <iostream>
+
+///checks the steady state allocates nothing: once a world's containers have grown to fit its load, a frame
+/// (Buffs fan-out, DamageEvents, Health updates, transform pass) shouldn't touch the heap
+///built by make.sh as allocTest, with -DWEDGE_COUNT_ALLOCATIONS
+
+static_assert(AllocationCounter::enabled(), "allocTest needs -DWEDGE_COUNT_ALLOCATIONS");
+
+int main() {
+	ExampleGameWorld world;
+
+	for (int i = 0; i < 1000; i++) {
+		std::vector<std::shared_ptr<IPartialComponent>> components;
+		components.push_back(std::make_shared<HealthPC>(HealthValue(1000.)));
+		components.push_back(std::make_shared<BuffPC>(BuffValue{1., 1000.}));
+		components.push_back(std::make_shared<BuffPC>(BuffValue{2., 1000.}));
+		world.makeEntity(components, Placement(Vec3(i, 0, 0)));
+	}
+
+	//the first frames grow event buffers, awake lists, etc
+	for (int i = 0; i < 10; i++) world.update(1. / 60.);
+
+	int failed = 0;
+	for (int i = 0; i < 100; i++) {
+		world.update(1. / 60.);
+
+		AllocationStats a = world.lastFrameAllocations().total();
+		if (a.allocations != 0) {
+			std::cout<<"warm frame "<<i<<" allocated "<<a<<std::endl;
+			failed++;
+		}
+	}
+
+	std::cout<<(failed ? "FAILED" : "passed")<<": 100 warm frames, "<<failed<<" allocating"<<std::endl;
+	return failed ? 1 : 0;
+}
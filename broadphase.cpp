@@ -0,0 +1,288 @@
+#include "broadphase.h"
+#include "actor.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+BroadphaseSystem::BroadphaseSystem(std::function<Entity*(EntityID)> idToEntity, EventBus& bus)
+    : SimpleSystem(idToEntity), begins(bus.channel<OverlapBeginEvent>()), ends(bus.channel<OverlapEndEvent>()),
+      deadProxies(0) {
+    addObserver(this);
+}
+
+void BroadphaseSystem::customUpdate() {
+    if (deadProxies > 0) dropDeadProxies();
+
+    //sleeping entities don't move, and touch()ing a collider wakes its entity
+    for (auto& p : proxies) {
+        if (!p.live) continue;
+
+        if (p.entity == nullptr) p.entity = getEntity(p.eID);
+        if (p.entity != nullptr && !p.entity->isAsleep()) refreshBounds(p);
+    }
+
+    for (int a = 0; a < 3; a++) {
+        for (auto& e : axes[a]) {
+            const Proxy& p = proxies[e.proxy];
+            e.value = e.isMax ? p.max[a] : p.min[a];
+        }
+        sortAxis(axes[a]);
+    }
+
+    if (!added[0].empty()) mergeAdded();
+}
+
+void BroadphaseSystem::moduleModified(SystemBase& sys, EntityID eID) {
+    auto it = proxyOf.find(eID);
+    if (it != proxyOf.end()) proxies[it->second].collider = *modules.at(eID);
+}
+
+void BroadphaseSystem::postCreate(EntityID eID) {
+    //journal recovery re-decodes modules in place, and postCreates them again
+    auto it = proxyOf.find(eID);
+    Entity* e = getEntity(eID);
+    if (it != proxyOf.end()) {
+        Proxy& p = proxies[it->second];
+        p.entity = e;
+        p.collider = *modules.at(eID);
+        if (e != nullptr) refreshBounds(p);
+        return;
+    }
+
+    std::uint32_t index;
+    if (!freeProxies.empty()) {
+        index = freeProxies.back();
+        freeProxies.pop_back();
+    }
+    else {
+        index = proxies.size();
+        proxies.push_back(Proxy{eID, nullptr, Collider(), {}, {}, 0, {}, false, false});
+    }
+
+    Proxy& p = proxies[index];
+    p = Proxy{eID, e, *modules.at(eID), {}, {}, 0, {}, true, true};
+    if (e != nullptr) refreshBounds(p);
+    proxyOf.insert(std::make_pair(eID, index));
+
+    //merged into the axes at the next update, which is where their first pairs begin
+    for (int a = 0; a < 3; a++) {
+        added[a].push_back(Endpoint{0., index, false});
+        added[a].push_back(Endpoint{0., index, true});
+    }
+}
+
+void BroadphaseSystem::preDestroy(EntityID eID) {
+    auto it = proxyOf.find(eID);
+    if (it == proxyOf.end()) return;
+
+    proxies[it->second].live = false;
+    proxyOf.erase(it);
+    deadProxies++;
+}
+
+bool BroadphaseSystem::overlapping(EntityID a, EntityID b) const {
+    auto pa = proxyOf.find(a);
+    auto pb = proxyOf.find(b);
+    if (pa == proxyOf.end() || pb == proxyOf.end()) return false;
+
+    return pairs.count(pairKey(pa->second, pb->second)) > 0;
+}
+
+void BroadphaseSystem::forEachPair(std::function<void(EntityID, EntityID)> f) const {
+    for (std::uint64_t key : pairs) {
+        const Proxy& a = proxies[key >> 32];
+        const Proxy& b = proxies[key & 0xFFFFFFFFu];
+        if (!a.live || !b.live) continue;
+
+        if (a.eID < b.eID) f(a.eID, b.eID);
+        else f(b.eID, a.eID);
+    }
+}
+
+MemoryReport BroadphaseSystem::memoryReport() const {
+    MemoryReport out = SimpleSystem::memoryReport();
+    out.add("proxies", vectorBytes(proxies) + vectorBytes(freeProxies) + hashContainerBytes(proxyOf));
+    out.add("endpoints", vectorBytes(axes[0]) + vectorBytes(axes[1]) + vectorBytes(axes[2])
+                         + vectorBytes(added[0]) + vectorBytes(added[1]) + vectorBytes(added[2]));
+    out.add("scratch", vectorBytes(merged) + vectorBytes(activeAll) + vectorBytes(activeAdded));
+    out.add("pairs", hashContainerBytes(pairs));
+    return out;
+}
+
+void BroadphaseSystem::compact() {
+    SimpleSystem::compact();
+
+    shrinkVector(freeProxies);
+    shrinkHashContainer(proxyOf);
+    for (auto& a : axes) shrinkVector(a);
+    for (auto& a : added) shrinkVector(a);
+    shrinkVector(merged);
+    shrinkVector(activeAll);
+    shrinkVector(activeAdded);
+    shrinkHashContainer(pairs);
+}
+
+std::uint64_t BroadphaseSystem::pairKey(std::uint32_t a, std::uint32_t b) {
+    if (b < a) std::swap(a, b);
+    return (std::uint64_t(a) << 32) | b;
+}
+
+void BroadphaseSystem::dropDeadProxies() {
+    for (auto it = pairs.begin(); it != pairs.end();) {
+        std::uint32_t a = *it >> 32;
+        std::uint32_t b = *it & 0xFFFFFFFFu;
+
+        if (proxies[a].live && proxies[b].live) {
+            ++it;
+            continue;
+        }
+
+        emitEnd(a, b);
+        proxies[a].overlaps--;
+        proxies[b].overlaps--;
+        it = pairs.erase(it);
+    }
+
+    auto dead = [this] (const Endpoint& e) { return !proxies[e.proxy].live; };
+    for (int a = 0; a < 3; a++) {
+        axes[a].erase(std::remove_if(axes[a].begin(), axes[a].end(), dead), axes[a].end());
+        added[a].erase(std::remove_if(added[a].begin(), added[a].end(), dead), added[a].end());
+    }
+
+    for (std::uint32_t i = 0; i < proxies.size(); i++) {
+        if (!proxies[i].live && proxies[i].eID.ID >= 0) {
+            proxies[i].eID = EntityID(-1);
+            freeProxies.push_back(i);
+        }
+    }
+    deadProxies = 0;
+}
+
+void BroadphaseSystem::refreshBounds(Proxy& p) {
+    const Collider& c = p.collider;
+    const Placement& pl = p.entity->pos;
+    Vec3 center = pl.pos + pl.dir.rotate(c.offset);
+
+    //the rotated box's extent along each world axis is the sum of its rotated half-axes' projections
+    Vec3 x = pl.dir.rotate(Vec3(c.halfExtents.x, 0., 0.));
+    Vec3 y = pl.dir.rotate(Vec3(0., c.halfExtents.y, 0.));
+    Vec3 z = pl.dir.rotate(Vec3(0., 0., c.halfExtents.z));
+    double extent[3] = {
+        std::abs(x.x) + std::abs(y.x) + std::abs(z.x),
+        std::abs(x.y) + std::abs(y.y) + std::abs(z.y),
+        std::abs(x.z) + std::abs(y.z) + std::abs(z.z)
+    };
+    double mid[3] = {center.x, center.y, center.z};
+
+    for (int a = 0; a < 3; a++) {
+        p.min[a] = mid[a] - extent[a];
+        p.max[a] = mid[a] + extent[a];
+    }
+}
+
+bool BroadphaseSystem::boundsOverlap(const Proxy& a, const Proxy& b) const {
+    for (int i = 0; i < 3; i++) {
+        if (a.max[i] < b.min[i] || b.max[i] < a.min[i]) return false;
+    }
+    return true;
+}
+
+void BroadphaseSystem::mergeAdded() {
+    for (int a = 0; a < 3; a++) {
+        for (auto& e : added[a]) {
+            const Proxy& p = proxies[e.proxy];
+            e.value = e.isMax ? p.max[a] : p.min[a];
+        }
+        std::sort(added[a].begin(), added[a].end(), [] (const Endpoint& l, const Endpoint& r) { return r.after(l); });
+
+        merged.resize(axes[a].size() + added[a].size());
+        std::merge(axes[a].begin(), axes[a].end(), added[a].begin(), added[a].end(), merged.begin(),
+                   [] (const Endpoint& l, const Endpoint& r) { return r.after(l); });
+        axes[a].swap(merged);
+    }
+
+    //one sweep along x finds the new colliders' pairs: everything open at a min overlaps it on x
+    activeAll.clear();
+    activeAdded.clear();
+    for (auto& e : axes[0]) {
+        Proxy& p = proxies[e.proxy];
+        if (e.isMax) {
+            if (p.added) deactivate(activeAdded, 1, e.proxy);
+            deactivate(activeAll, 0, e.proxy);
+            continue;
+        }
+
+        for (std::uint32_t other : p.added ? activeAll : activeAdded) {
+            if (boundsOverlap(p, proxies[other])) addPair(e.proxy, other);
+        }
+        activate(activeAll, 0, e.proxy);
+        if (p.added) activate(activeAdded, 1, e.proxy);
+    }
+
+    for (auto& e : added[0]) proxies[e.proxy].added = false;
+    for (auto& a : added) a.clear();
+}
+
+void BroadphaseSystem::activate(std::vector<std::uint32_t>& active, int which, std::uint32_t proxy) {
+    proxies[proxy].activeAt[which] = active.size();
+    active.push_back(proxy);
+}
+
+//order doesn't matter to the sweep, so the last one takes the hole
+void BroadphaseSystem::deactivate(std::vector<std::uint32_t>& active, int which, std::uint32_t proxy) {
+    std::uint32_t at = proxies[proxy].activeAt[which];
+    active[at] = active.back();
+    proxies[active[at]].activeAt[which] = at;
+    active.pop_back();
+}
+
+void BroadphaseSystem::sortAxis(std::vector<Endpoint>& axis) {
+    for (std::size_t i = 1; i < axis.size(); i++) {
+        Endpoint moving = axis[i];
+
+        std::size_t j = i;
+        while (j > 0 && axis[j - 1].after(moving)) {
+            swapped(moving, axis[j - 1]);
+            axis[j] = axis[j - 1];
+            j--;
+        }
+        axis[j] = moving;
+    }
+}
+
+void BroadphaseSystem::swapped(const Endpoint& movedLeft, const Endpoint& movedRight) {
+    if (movedLeft.proxy == movedRight.proxy) return;
+
+    //a min moving below a max: the two may now overlap on this axis, so check all three
+    if (!movedLeft.isMax && movedRight.isMax) {
+        if (boundsOverlap(proxies[movedLeft.proxy], proxies[movedRight.proxy])) addPair(movedLeft.proxy, movedRight.proxy);
+    }
+    //a max moving below a min: separated on this axis; most colliders overlap nothing, so skip the lookup for them
+    else if (movedLeft.isMax && !movedRight.isMax) {
+        if (proxies[movedLeft.proxy].overlaps > 0 && proxies[movedRight.proxy].overlaps > 0) {
+            removePair(movedLeft.proxy, movedRight.proxy);
+        }
+    }
+}
+
+void BroadphaseSystem::addPair(std::uint32_t a, std::uint32_t b) {
+    if (!pairs.insert(pairKey(a, b)).second) return;
+    proxies[a].overlaps++;
+    proxies[b].overlaps++;
+
+    EntityID ea = proxies[a].eID, eb = proxies[b].eID;
+    begins.emit(ea < eb ? OverlapBeginEvent{ea, eb} : OverlapBeginEvent{eb, ea});
+}
+
+void BroadphaseSystem::removePair(std::uint32_t a, std::uint32_t b) {
+    if (pairs.erase(pairKey(a, b)) == 0) return;
+    proxies[a].overlaps--;
+    proxies[b].overlaps--;
+    emitEnd(a, b);
+}
+
+void BroadphaseSystem::emitEnd(std::uint32_t a, std::uint32_t b) {
+    EntityID ea = proxies[a].eID, eb = proxies[b].eID;
+    ends.emit(ea < eb ? OverlapEndEvent{ea, eb} : OverlapEndEvent{eb, ea});
+}
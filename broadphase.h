@@ -0,0 +1,135 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "component.h"
+#include "eventbus.h"
+#include "3dmath.h"
+
+///a box collider: halfExtents along the entity's local axes, centered at offset (also local) from its Placement
+struct Collider {
+    Vec3 halfExtents;
+    Vec3 offset;
+};
+
+typedef TypedPartialComponent<Collider, SystemType::Broadphase> ColliderPC;
+
+///published on the EventBus when two colliders' world AABBs start/stop overlapping; one event per pair,
+/// with eID < other (so drainSortedByEntity and wakeOnEvent see the lower EID)
+struct OverlapBeginEvent {
+    EntityID eID;
+    EntityID other;
+};
+
+struct OverlapEndEvent {
+    EntityID eID;
+    EntityID other;
+};
+
+///sweep-and-prune broadphase: keeps every collider's world AABB as min/max endpoints in one sorted list per axis.
+/// update() refreshes the AABBs from the entities' Placements and re-sorts each list with insertion sort, which is
+/// close to O(n) when things move a little per frame; every swap of a min past a max (or back) is exactly where a
+/// pair can start or stop overlapping, so the pair cache is maintained from the swaps, with no O(n^2) pass
+///colliders are added in postCreate and removed in preDestroy/preRemove, so every creation path (PartialComponents,
+/// prefabs, snapshots, journal recovery) and destroyEntityModules keep it current; a removed collider's pairs end
+/// (with OverlapEndEvents) at the next update. Each proxy keeps a copy of its Collider, so change one through
+/// modify()/touch(), ex:
+///  BroadphaseSystem broadphase(ID2ENT, getEventBus());   //in a World's constructor
+///  world.makeEntity(p, new ColliderPC(Collider{Vec3(1, 1, 1), Vec3()}));
+///  broadphase.update();                                 //in customUpdate, after movement
+///  for (auto& e : world.eventChannel<OverlapBeginEvent>().events()) ...  //next frame
+class BroadphaseSystem : public SimpleSystem<Collider, SystemType::Broadphase>, public ModuleObserver {
+    public:
+    BroadphaseSystem(std::function<Entity*(EntityID)> idToEntity, EventBus& bus);
+
+    void customUpdate();
+
+    ///its own observer, to re-copy touched Colliders
+    void moduleModified(SystemBase& sys, EntityID eID);
+
+    void postCreate(EntityID eID);
+    void preDestroy(EntityID eID);
+    void preRemove(EntityID eID) { preDestroy(eID); }
+
+    bool overlapping(EntityID a, EntityID b) const;
+    ///f(EntityID a, EntityID b) for every overlapping pair, with a < b, in no particular order
+    void forEachPair(std::function<void(EntityID, EntityID)> f) const;
+    std::size_t pairCount() const { return pairs.size(); }
+
+    MemoryReport memoryReport() const;
+    void compact();
+
+    private:
+    struct Proxy {
+        EntityID eID;
+        ///cached, so update() reads Placements without a lookup per collider; nullptr until the entity exists
+        Entity* entity;
+        Collider collider;
+        double min[3];
+        double max[3];
+        ///pairs it's in
+        std::uint32_t overlaps;
+        ///its positions in activeAll/activeAdded, during mergeAdded's sweep
+        std::uint32_t activeAt[2];
+        ///false from preDestroy until the next update drops its endpoints and pairs
+        bool live;
+        ///true from postCreate until the next update merges its endpoints into the axes
+        bool added;
+    };
+
+    struct Endpoint {
+        double value;
+        std::uint32_t proxy;
+        bool isMax;
+
+        ///at equal values mins sort first, so touching boxes count as overlapping
+        bool after(const Endpoint& other) const {
+            return value > other.value || (value == other.value && isMax && !other.isMax);
+        }
+    };
+
+    EventChannel<OverlapBeginEvent>& begins;
+    EventChannel<OverlapEndEvent>& ends;
+
+    std::vector<Proxy> proxies;
+    std::vector<std::uint32_t> freeProxies;
+    std::unordered_map<EntityID, std::uint32_t> proxyOf;
+    std::size_t deadProxies;
+
+    std::vector<Endpoint> axes[3];
+    ///endpoints of colliders created since the last update; inserting them one at a time would sort each across
+    /// the whole axis, so they're sorted together and merged in
+    std::vector<Endpoint> added[3];
+    std::vector<Endpoint> merged;
+    std::vector<std::uint32_t> activeAll;
+    std::vector<std::uint32_t> activeAdded;
+    ///both proxy indices of each overlapping pair, lower one in the high bits; proxies (not EIDs), since a removed
+    /// collider's proxy lives on until the next update, possibly next to a new one for the same entity
+    std::unordered_set<std::uint64_t> pairs;
+
+    static std::uint64_t pairKey(std::uint32_t a, std::uint32_t b);
+
+    ///ends every pair of a removed collider, then drops their endpoints and frees their proxies
+    void dropDeadProxies();
+
+    ///the collider's world AABB, from its entity's Placement
+    void refreshBounds(Proxy& p);
+    bool boundsOverlap(const Proxy& a, const Proxy& b) const;
+
+    ///merges added into the axes, and adds the new colliders' pairs
+    void mergeAdded();
+    void activate(std::vector<std::uint32_t>& active, int which, std::uint32_t proxy);
+    void deactivate(std::vector<std::uint32_t>& active, int which, std::uint32_t proxy);
+
+    ///insertion sort of one axis; swaps report pairs starting/stopping to overlap
+    void sortAxis(std::vector<Endpoint>& axis);
+    void swapped(const Endpoint& movedLeft, const Endpoint& movedRight);
+
+    void addPair(std::uint32_t a, std::uint32_t b);
+    void removePair(std::uint32_t a, std::uint32_t b);
+    void emitEnd(std::uint32_t a, std::uint32_t b);
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+///binary encoding of Templates/Instances, used by the Journal
+///trivially copyable types are supported out of the box; specialize JournalCodec for anything else, ex:
+///  template<> struct JournalCodec<Inventory> {
+///      static constexpr bool supported = true;
+///      static void encode(const Inventory& i, std::vector<char>& out);
+///      static Inventory decode(const char* data, std::size_t size);
+///  };
+template<class T, class Enable = void>
+struct JournalCodec {
+    static constexpr bool supported = false;
+};
+
+template<class T>
+struct JournalCodec<T, typename std::enable_if<std::is_trivially_copyable<T>::value>::type> {
+    static constexpr bool supported = true;
+
+    static void encode(const T& t, std::vector<char>& out) {
+        const char* bytes = reinterpret_cast<const char*>(&t);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    static T decode(const char* data, std::size_t size) {
+        alignas(T) unsigned char buffer[sizeof(T)];
+        std::memcpy(buffer, data, sizeof(T));
+        return *std::launder(reinterpret_cast<T*>(buffer));
+    }
+};
+
+///whether a System's Instances can be duplicated by copying them as is (see WorldBase::duplicateSnapshot),
+/// skipping _recreatePartialComponent and duplicateUpdate
+///off by default; turn it on for trivially copyable types that hold no EntityIDs, in Systems that don't override
+/// _recreatePartialComponent, ex:
+///  template<> struct RawModuleCopy<HealthValue> : std::true_type {};
+template<class T>
+struct RawModuleCopy : std::false_type {};
+
+template<class T>
+void encodePOD(const T& t, std::vector<char>& out) {
+    JournalCodec<T>::encode(t, out);
+}
+
+///reads a T at data+offset, and advances offset past it
+template<class T>
+T decodePOD(const char* data, std::size_t& offset) {
+    T out = JournalCodec<T>::decode(data + offset, sizeof(T));
+    offset += sizeof(T);
+    return out;
+}
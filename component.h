@@ -6,21 +6,44 @@
 #include <unordered_set>
 #include <vector>
 #include <functional>
+#include <algorithm>
+#include <type_traits>
+#include <tuple>
+#include <chrono>
+#include <span>
+#include <cstddef>
+#include <cstdint>
 #include <cassert>
 
 #include <iostream>
 
+#include "memory.h"
+#include "codec.h"
+#include "tagset.h"
+
 ///maybe put this in its own file
+///a slot in the World's entity table, plus a generation: a deleted entity's slot is reused by a later entity at the
+/// next generation, so the IDs of deleted entities never match a live one
 struct EntityID {
-    int ID;
-    EntityID(int i)
+    static constexpr int SlotBits = 32;
+
+    std::int64_t ID;
+    EntityID(std::int64_t i)
         : ID(i) {}
+    EntityID(std::uint32_t slot, std::uint32_t generation)
+        : ID((std::int64_t(generation) << SlotBits) | slot) {}
+
+    std::uint32_t slot() const { return std::uint32_t(ID); }
+    std::uint32_t generation() const { return std::uint32_t(ID >> SlotBits); }
+    ///the ID of the next entity in this slot; generations wrap before they'd make the ID negative
+    EntityID reused() const { return EntityID(slot(), (generation() + 1) & 0x7FFFFFFFu); }
 
     bool operator==(const EntityID& other) const { return ID == other.ID; }
 
     bool operator< (const EntityID& other) const { return ID < other.ID; }
 
     friend std::ostream& operator<<(std::ostream& o, const EntityID& e) {
+        if (e.ID > 0 && e.generation() > 0) return o<<"EID"<<e.slot()<<"v"<<e.generation();
         return o<<"EID"<<e.ID;
     }
 };
@@ -53,14 +76,26 @@ template<> struct std::hash<ModuleID> {
 };
 
 enum SystemType {
-    Health
+    Health,
+    Buffs,
 	//AgentSystem,
 	//HitboxSystem,
 	//etc
+
+	//built-in systems, owned by WorldBase
+	Tasks,
+
+	//library systems, added to a World like user ones
+	Broadphase,
+	Nav
 };
 
 struct Entity;
 
+///points e's cached module for st at module (see Entity::get); defined in actor.cpp so Systems can call it
+/// before Entity is a complete type
+void refreshModuleSlot(Entity& e, SystemType st, void* module);
+
 struct EmptyStruct {};
 class IPartialComponent;
 
@@ -69,6 +104,176 @@ class IPartialComponent;
 /// not a very good name, but much more concise than ComponentData or w/e so I'm going with it
 
 
+template<class Template>
+class PartialComponent;
+
+///a point-in-time copy of one System's modules (see WorldBase::snapshot)
+class IModuleColumn {
+    public:
+    virtual ~IModuleColumn() {}
+
+    virtual SystemType getType() const =0;
+    virtual std::size_t size() const =0;
+    virtual EntityID eid(std::size_t i) const =0;
+    ///only reads the column, so it's safe to call from another thread while the World keeps running, or after it's gone
+    virtual std::shared_ptr<IPartialComponent> recreatePartialComponent(std::size_t i) const =0;
+    ///false for columns only good for copying Instances (ex: into a FrontBuffer), not for saving
+    virtual bool recreatable() const { return true; }
+    virtual std::size_t bytes() const =0;
+};
+
+///Template is the Instance and it opted in to RawModuleCopy, so saved modules are plain copies with nothing to remap
+template<class Template, class Instance>
+constexpr bool rawCopyModules = std::is_same<Template, Instance>::value && RawModuleCopy<Instance>::value
+                                && std::is_trivially_copyable<Instance>::value;
+
+///turns an Instance copied into a snapshot column back into a PartialComponent; it runs off the update thread, and
+/// possibly after the System is gone, so it's a free function rather than the System's _recreatePartialComponent
+///Template == Instance is a plain copy, as in SimpleSystem/SimpleMultiSystem; a System that recreates its modules some
+/// other way specializes this to match (or its snapshots fall back to recreatePartialComponents), ex:
+///  template<> struct ModuleRecreator<ItemTemplate, Item> {
+///      static constexpr bool supported = true;
+///      static std::shared_ptr<PartialComponent<ItemTemplate>> recreate(const Item& i, SystemType st);
+///  };
+template<class Template, class Instance>
+struct ModuleRecreator {
+    static constexpr bool supported = false;
+};
+
+template<class Instance>
+struct ModuleRecreator<Instance, Instance> {
+    static constexpr bool supported = true;
+
+    static std::shared_ptr<PartialComponent<Instance>> recreate(const Instance& i, SystemType st) {
+        return std::make_shared<PartialComponent<Instance>>(i, st);
+    }
+};
+
+///one contiguous array per field
+template<class Template, class Instance>
+class ModuleColumn : public IModuleColumn {
+    public:
+    typedef std::shared_ptr<PartialComponent<Template>> (*Recreator)(const Instance&, SystemType);
+
+    SystemType type;
+    std::vector<EntityID> eids;
+    std::vector<SystemType> moduleTypes;
+    std::vector<Instance> instances;
+    Recreator recreator;
+
+    ModuleColumn(SystemType st, Recreator r)
+        : type(st), recreator(r) {}
+
+    void reserve(std::size_t n) {
+        eids.reserve(n);
+        moduleTypes.reserve(n);
+        instances.reserve(n);
+    }
+
+    void push(EntityID eID, SystemType st, const Instance& i) {
+        eids.push_back(eID);
+        moduleTypes.push_back(st);
+        instances.push_back(i);
+    }
+
+    SystemType getType() const { return type; }
+    std::size_t size() const { return eids.size(); }
+    EntityID eid(std::size_t i) const { return eids[i]; }
+
+    std::shared_ptr<IPartialComponent> recreatePartialComponent(std::size_t i) const {
+        assert(recreator != nullptr);
+        return recreator(instances[i], moduleTypes[i]);
+    }
+    bool recreatable() const { return recreator != nullptr; }
+
+    ///every Instance as one block, ex: to write a save with a single fwrite
+    std::span<const std::byte> instanceBytes() const requires std::is_trivially_copyable<Instance>::value {
+        return std::as_bytes(std::span<const Instance>(instances));
+    }
+
+    std::size_t bytes() const {
+        return vectorBytes(eids) + vectorBytes(moduleTypes) + vectorBytes(instances);
+    }
+};
+
+///for Systems whose Instances can't be copied; PartialComponents are made when the column is filled
+class PartialComponentColumn : public IModuleColumn {
+    public:
+    SystemType type;
+    std::vector<EntityID> eids;
+    std::vector<std::shared_ptr<IPartialComponent>> components;
+
+    PartialComponentColumn(SystemType st)
+        : type(st) {}
+
+    SystemType getType() const { return type; }
+    std::size_t size() const { return eids.size(); }
+    EntityID eid(std::size_t i) const { return eids[i]; }
+    std::shared_ptr<IPartialComponent> recreatePartialComponent(std::size_t i) const { return components[i]; }
+    std::size_t bytes() const { return vectorBytes(eids) + vectorBytes(components); }
+};
+
+
+///per-module bookkeeping kept by System/MultiSystem
+struct ModuleSlot {
+    SystemType type;
+    ///index into the System's awake list, or -1 while the entity sleeps
+    int awakeIndex;
+};
+
+///persistent position for amortized iteration (applyFunctionToModulesSliced/Budgeted)
+/// a pass walks the awake EIDs that had modules when it started; modules added mid-pass wait for the next pass,
+/// and ones removed or put to sleep mid-pass are skipped
+struct ModuleSlicer {
+    std::vector<EntityID> pass;
+    std::size_t position = 0;
+    std::size_t perCall = 0;
+    std::size_t completedPasses = 0;
+
+    bool passDone() const { return position >= pass.size(); }
+    ///drops the current pass; the next call starts a fresh one
+    void reset() { pass.clear(); position = 0; }
+};
+
+///runs visit(eID) over the slicer's pass until the pass ends or keepGoing(visited so far) says stop,
+/// checked every checkEvery modules; starts a new pass from fill() first if the last one finished
+///returns true if this call finished a pass
+template <class Fill, class Visit, class KeepGoing>
+bool runModuleSlice(ModuleSlicer& slicer, Fill fill, Visit visit, KeepGoing keepGoing, std::size_t checkEvery) {
+    if (slicer.passDone()) {
+        slicer.pass.clear();
+        slicer.position = 0;
+        fill(slicer.pass);
+    }
+
+    std::size_t done = 0;
+    while (!slicer.passDone()) {
+        if (done > 0 && done % checkEvery == 0 && !keepGoing(done)) break;
+
+        visit(slicer.pass[slicer.position++]);
+        done++;
+    }
+
+    if (!slicer.passDone()) return false;
+    slicer.completedPasses++;
+    return true;
+}
+
+class SystemBase;
+
+///sees module creation/mutation/destruction in the Systems it's registered with (see SystemBase::addObserver)
+/// mutations are only seen when the System's owner calls touch()/modify() after writing to a module
+class ModuleObserver {
+    public:
+    virtual ~ModuleObserver() {}
+
+    virtual void moduleCreated(SystemBase& sys, EntityID eID) {}
+    virtual void moduleModified(SystemBase& sys, EntityID eID) {}
+    ///called before the module is erased
+    virtual void moduleDestroyed(SystemBase& sys, EntityID eID) {}
+};
+
+
 ///this exists so I have a base I can dynamic_cast into templated ISystems
 /// also, a convenient place to put destroyEntityModules(eID), the function called to clean up after an entity being destroyed
 class SystemBase {
@@ -77,9 +282,59 @@ class SystemBase {
 
     virtual void destroyEntityModules(EntityID eID) =0;
     virtual void postCreate(EntityID eID) {}
+
+    ///removes a live entity's module(s) from this System, without destroying the entity
+    /// returns true if eID has no modules left here, so the caller can drop the System from the Entity
+    virtual bool removeModule(EntityID eID) =0;
+    virtual bool removeModule(EntityID eID, ModuleID mID) {
+        throw std::invalid_argument("removeModule with a ModuleID is only supported by MultiSystems");
+    }
+    virtual bool hasModules(EntityID eID) const =0;
     virtual std::vector<std::shared_ptr<IPartialComponent>> recreatePartialComponents(EntityID eid) =0;
 
     virtual SystemType getType() const =0;
+
+    virtual MemoryReport memoryReport() const =0;
+
+    ///shrinks containers left oversized by load spikes; called by WorldBase's incremental compaction
+    virtual void compact() {}
+
+    ///block copy of every module, or of only eids' modules (in that order) if given; nullptr if this System can't
+    /// copy its Instances (WorldBase::snapshot falls back to recreatePartialComponents then)
+    virtual std::unique_ptr<IModuleColumn> snapshotModules(const std::vector<EntityID>* eids) const { return nullptr; }
+    ///bulk-inserts a column made by the same System type; returns false if it can't
+    /// (WorldBase::loadSnapshot then creates the modules from PartialComponents instead)
+    ///with eidMapping, each module goes to eidMapping.at(its eid) (WorldBase::duplicateSnapshot); Systems only take
+    /// that for rawCopyModules, since other modules may need their PartialComponent's duplicateUpdate
+    virtual bool loadColumn(const IModuleColumn& column, const std::unordered_map<EntityID, EntityID>* eidMapping) { return false; }
+
+    ///binary form of all of eID's modules here, appended to out (see Journal)
+    /// returns false if eID has no modules or the Instance type has no JournalCodec
+    virtual bool encodeModules(EntityID eID, std::vector<char>& out) const { return false; }
+    ///replaces eID's modules with ones decoded from encodeModules' output
+    virtual bool decodeModules(EntityID eID, const char* data, std::size_t size) { return false; }
+    virtual bool canEncodeModules() const { return false; }
+
+    ///moves eID's modules in/out of the System's hot iteration range; called by WorldBase::sleep/wake
+    virtual void setAwake(EntityID eID, bool isAwake) {}
+
+    ///eID's Instance, for Entity's module cache (Entity::get); nullptr for Systems without exactly one Instance per entity
+    virtual void* modulePtr(EntityID eID) { return nullptr; }
+
+    void addObserver(ModuleObserver* o) {
+        if (std::find(observers.begin(), observers.end(), o) == observers.end()) observers.push_back(o);
+    }
+
+    void removeObserver(ModuleObserver* o) {
+        observers.erase(std::remove(observers.begin(), observers.end(), o), observers.end());
+    }
+
+    protected:
+    std::vector<ModuleObserver*> observers;
+
+    void notifyCreated(EntityID eID) { for (ModuleObserver* o : observers) o->moduleCreated(*this, eID); }
+    void notifyModified(EntityID eID) { for (ModuleObserver* o : observers) o->moduleModified(*this, eID); }
+    void notifyDestroyed(EntityID eID) { for (ModuleObserver* o : observers) o->moduleDestroyed(*this, eID); }
 };
 
 
@@ -92,6 +347,8 @@ class ISystem : public SystemBase {
     //virtual Instance* instantiateTemplate(const Template& t) const =0;
     //virtual void addModule(int ID, std::weak_ptr<Instance> module) =0;
     virtual void createModule(EntityID eID, const Template& t, SystemType st) =0;
+    ///lets rvalue Templates (ex: from emplace) be moved into the Instance
+    virtual void createModule(EntityID eID, Template&& t, SystemType st) =0;
 };
 template<class Template>
 class PartialComponent;
@@ -99,38 +356,116 @@ class PartialComponent;
 ///0-1 modules per entity
 template <class Template, class Instance, SystemType TYPE, class ...UpdateInputs>
 class System : public ISystem<Template> {
-    std::unordered_map<EntityID, SystemType> moduleTypes;
+    std::unordered_map<EntityID, ModuleSlot> slots;
     std::unordered_map<Instance*, EntityID> moduleToEID;
+    ///modules of awake entities, contiguous so applyFunctionToModules skips sleeping ones for free
+    std::vector<std::pair<EntityID, Instance*>> awake;
+
+    void eraseSlot(EntityID eID) {
+        auto it = slots.find(eID);
+        if (it == slots.end()) return;
+
+        removeAwake(it->second);
+        slots.erase(it);
+    }
+
+    void removeAwake(ModuleSlot& slot) {
+        if (slot.awakeIndex < 0) return;
+
+        awake[slot.awakeIndex] = awake.back();
+        slots.at(awake[slot.awakeIndex].first).awakeIndex = slot.awakeIndex;
+        awake.pop_back();
+        slot.awakeIndex = -1;
+    }
+
     protected:
     const std::function<Entity*(EntityID)> getEntity;
 
     std::unordered_map<EntityID, std::unique_ptr<Instance>> modules;
 
+    bool repackOnCompact;
+
 
     virtual std::unique_ptr<Instance> instantiateTemplate(const Template& t) =0;
+    ///override alongside the const& version when an Instance can take over a Template's resources
+    virtual std::unique_ptr<Instance> instantiateTemplate(Template&& t) {
+        return instantiateTemplate(static_cast<const Template&>(t));
+    }
 
     virtual std::shared_ptr<PartialComponent<Template>> _recreatePartialComponent(const Instance& i, SystemType st) const =0;
 
     virtual void customUpdate(UpdateInputs... ui) =0;
 
+    void insertModule(EntityID eID, std::unique_ptr<Instance>&& instance, SystemType st) {
+        assert(modules.count(eID) == 0);
+
+        Instance* m = instance.get();
+        modules.insert(std::make_pair(eID, std::move(instance)));
+        slots[eID] = ModuleSlot{st, (int) awake.size()};
+        awake.push_back(std::make_pair(eID, m));
+
+        moduleToEID.insert(std::pair<Instance*, EntityID>(m, eID));
+        this->notifyCreated(eID);
+    }
+
+    void eraseModule(EntityID eID) {
+        auto it = modules.find(eID);
+        if (it == modules.end()) return;
+
+        this->notifyDestroyed(eID);
+        clearEntitySlot(eID);
+        moduleToEID.erase(it->second.get());
+        modules.erase(it);
+        eraseSlot(eID);
+    }
+
+    ///relocated Instances need the owning Entity's cached pointer updated
+    void refreshEntitySlot(EntityID eID) {
+        Entity* e = getEntity(eID);
+        if (e != nullptr) refreshModuleSlot(*e, TYPE, modules.at(eID).get());
+    }
+
+    ///so get/tryGet don't hand out an erased Instance
+    void clearEntitySlot(EntityID eID) {
+        Entity* e = getEntity(eID);
+        if (e != nullptr) refreshModuleSlot(*e, TYPE, nullptr);
+    }
+
     public:
+    static constexpr SystemType Type = TYPE;
+    ///Entity::get<Sys>() works for Systems with exactly one Instance per entity
+    static constexpr bool SingleModule = true;
+    typedef Template TemplateType;
+    typedef Instance InstanceType;
+
     System(std::function<Entity*(EntityID)> _idToEntity)
-        : getEntity(_idToEntity) {}
+        : getEntity(_idToEntity), repackOnCompact(false) {}
 
     virtual ~System() {}
 
     void update(UpdateInputs... ui) {
-        customUpdate(ui...);
+        customUpdate(std::forward<UpdateInputs>(ui)...);
     }
 
     void createModule(EntityID eID, const Template& t, SystemType st) {
-        assert(modules.count(eID) == 0);
+        insertModule(eID, instantiateTemplate(t), st);
+    }
 
-        modules.insert(std::make_pair<EntityID, std::unique_ptr<Instance>>(EntityID(eID), std::move(instantiateTemplate(t))));
-        moduleTypes[eID] = st;
+    void createModule(EntityID eID, Template&& t, SystemType st) {
+        insertModule(eID, instantiateTemplate(std::move(t)), st);
+    }
 
-        Instance* m = modules.at(eID).get();
-        moduleToEID.insert(std::pair<Instance*, EntityID>(m, eID));
+    ///non-virtual creation path for worlds that know the concrete System type at compile time (see StaticWorld)
+    /// falls back to the virtual call if Derived's instantiateTemplate isn't public
+    template <class Derived>
+    void createModuleStatic(EntityID eID, const Template& t, SystemType st) {
+        Derived& d = *static_cast<Derived*>(this);
+        if constexpr (requires { d.Derived::instantiateTemplate(t); }) {
+            insertModule(eID, d.Derived::instantiateTemplate(t), st);
+        }
+        else {
+            insertModule(eID, instantiateTemplate(t), st);
+        }
     }
 
     SystemType getType() const {
@@ -139,32 +474,132 @@ class System : public ISystem<Template> {
 
     void destroyEntityModules(EntityID eID) {
         preDestroy(eID);
+        eraseModule(eID);
+    }
 
-        if (modules.count(eID)) {
-            moduleToEID.erase(modules.at(eID).get());
-        }
+    bool removeModule(EntityID eID) {
+        if (!modules.count(eID)) return true;
 
-        modules.erase(eID);
-        moduleTypes.erase(eID);
+        preRemove(eID);
+        eraseModule(eID);
+        return true;
+    }
 
+    bool hasModules(EntityID eID) const {
+        return has(eID);
     }
 
 
     virtual void preDestroy(EntityID eID) {}
+    ///called before a module is removed from a live entity (WorldBase::removeComponent)
+    virtual void preRemove(EntityID eID) {}
+
+    ///override to count heap memory owned by an Instance (vectors, strings, ...)
+    virtual std::size_t instanceHeapBytes(const Instance& i) const { return 0; }
+
+    MemoryReport memoryReport() const {
+        MemoryReport out(std::string("System ") + std::to_string(TYPE));
+
+        std::size_t instances = 0;
+        for (auto& m : modules) instances += sizeof(Instance) + instanceHeapBytes(*m.second);
+
+        out.add("modules", hashContainerBytes(modules));
+        out.add("slots", hashContainerBytes(slots));
+        out.add("awake", vectorBytes(awake));
+        out.add("moduleToEID", hashContainerBytes(moduleToEID));
+        out.add("instances", instances);
+        return out;
+    }
+
+    ///reallocates every Instance in EntityID order during compact(), so iterating by EID walks memory linearly
+    /// this invalidates Instance pointers held outside the System, so it's off by default
+    void setRepackOnCompact(bool repack) { repackOnCompact = repack; }
+
+    void compact() {
+        shrinkHashContainer(modules);
+        shrinkHashContainer(slots);
+        shrinkVector(awake);
+        shrinkHashContainer(moduleToEID);
+
+        if (repackOnCompact) repack();
+    }
+
+    void repack() {
+        if constexpr (std::is_move_constructible<Instance>::value) {
+            std::vector<EntityID> order;
+            order.reserve(modules.size());
+            for (auto& m : modules) order.push_back(m.first);
+            std::sort(order.begin(), order.end());
+
+            //keep the old Instances alive until every new one is allocated, so the allocator can't hand
+            // a just-freed block back out of order
+            std::vector<std::unique_ptr<Instance>> old;
+            old.reserve(modules.size());
+            moduleToEID.clear();
+
+            for (EntityID eID : order) {
+                std::unique_ptr<Instance>& slot = modules.at(eID);
+                std::unique_ptr<Instance> moved = std::make_unique<Instance>(std::move(*slot));
+
+                old.push_back(std::move(slot));
+                slot = std::move(moved);
+                moduleToEID.insert(std::pair<Instance*, EntityID>(slot.get(), eID));
+                refreshEntitySlot(eID);
+            }
+
+            //rebuild the awake list in the same order, so applyFunctionToModules walks memory linearly too
+            awake.clear();
+            for (EntityID eID : order) {
+                ModuleSlot& s = slots.at(eID);
+                if (s.awakeIndex < 0) continue;
+
+                s.awakeIndex = awake.size();
+                awake.push_back(std::make_pair(eID, modules.at(eID).get()));
+            }
+        }
+    }
 
     EntityID moduleEID(Instance* ptr) {
         return moduleToEID.at(ptr);
     }
 
     std::shared_ptr<PartialComponent<Template>> recreatePartialComponent(const Instance& i, EntityID eID) const {
-        return _recreatePartialComponent(i, moduleTypes.at(eID));
+        return _recreatePartialComponent(i, slots.at(eID).type);
     }
 
     bool has(EntityID eID) const {
         return modules.count(eID) > 0;
     }
 
+    ///tells observers (journals, indexes, ...) that eID's module was written to
+    void touch(EntityID eID) {
+        this->notifyModified(eID);
+    }
+
+    ///func(Instance&), then touch
+    template <class F>
+    void modify(EntityID eID, F func) {
+        func(*modules.at(eID));
+        touch(eID);
+    }
+
+    ///skips modules of sleeping entities (see WorldBase::sleep)
+    ///func may sleep/remove its own entity; sleeping a different entity mid-loop can skip one module this pass
     void applyFunctionToModules(std::function<void(EntityID, Entity&, Instance&)> func) {
+        for (std::size_t i = 0; i < awake.size();) {
+            EntityID eID = awake[i].first;
+            Entity* ePtr = getEntity(eID);
+            assert(ePtr != nullptr);
+
+            func(eID, *ePtr, *awake[i].second);
+
+            //if func took eID out of the awake list, another module was swapped into slot i
+            if (i < awake.size() && awake[i].first == eID) i++;
+        }
+    }
+
+    ///includes sleeping entities
+    void applyFunctionToAllModules(std::function<void(EntityID, Entity&, Instance&)> func) {
         for (auto& i : modules) {
             Entity* ePtr = getEntity(i.first);
             assert(ePtr != nullptr);
@@ -174,6 +609,73 @@ class System : public ISystem<Template> {
         }
     }
 
+    void* modulePtr(EntityID eID) {
+        auto it = modules.find(eID);
+        return it == modules.end() ? nullptr : it->second.get();
+    }
+
+    void setAwake(EntityID eID, bool isAwake) {
+        auto it = slots.find(eID);
+        if (it == slots.end() || isAwake == (it->second.awakeIndex >= 0)) return;
+
+        if (isAwake) {
+            it->second.awakeIndex = awake.size();
+            awake.push_back(std::make_pair(eID, modules.at(eID).get()));
+        }
+        else {
+            removeAwake(it->second);
+        }
+    }
+
+    std::size_t awakeCount() const { return awake.size(); }
+    std::size_t moduleCount() const { return modules.size(); }
+
+    ///amortized iteration: each call handles 1/slices of the modules (sized at the start of a pass),
+    /// so a full pass takes `slices` calls; returns true when a call finishes a pass
+    bool applyFunctionToModulesSliced(ModuleSlicer& slicer, std::size_t slices, std::function<void(EntityID, Entity&, Instance&)> func) {
+        assert(slices > 0);
+
+        return runModuleSlice(slicer, [&] (std::vector<EntityID>& pass) {
+            fillPass(pass);
+            slicer.perCall = (pass.size() + slices - 1) / slices;
+        }, [&] (EntityID eID) {
+            visitModules(eID, func);
+        }, [&] (std::size_t done) {
+            return done < slicer.perCall;
+        }, 1);
+    }
+
+    ///amortized iteration: stops once budgetSeconds have passed (checked every 16 entities) and resumes from there
+    /// on the next call; returns true when a call finishes a pass
+    bool applyFunctionToModulesBudgeted(ModuleSlicer& slicer, double budgetSeconds, std::function<void(EntityID, Entity&, Instance&)> func) {
+        auto start = std::chrono::steady_clock::now();
+
+        return runModuleSlice(slicer, [&] (std::vector<EntityID>& pass) {
+            fillPass(pass);
+        }, [&] (EntityID eID) {
+            visitModules(eID, func);
+        }, [&] (std::size_t) {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < budgetSeconds;
+        }, 16);
+    }
+
+    private:
+    void fillPass(std::vector<EntityID>& pass) const {
+        pass.reserve(awake.size());
+        for (auto& a : awake) pass.push_back(a.first);
+    }
+
+    void visitModules(EntityID eID, std::function<void(EntityID, Entity&, Instance&)>& func) {
+        auto it = modules.find(eID);
+        if (it == modules.end() || slots.at(eID).awakeIndex < 0) return;
+
+        Entity* ePtr = getEntity(eID);
+        assert(ePtr != nullptr);
+        func(eID, *ePtr, *it->second);
+    }
+
+    public:
+
 
     std::vector<std::shared_ptr<IPartialComponent>> recreatePartialComponents(EntityID eid) {
         std::vector<std::shared_ptr<IPartialComponent>> out;
@@ -184,13 +686,115 @@ class System : public ISystem<Template> {
 
         return out;
     }
+
+    ///the column recreates PartialComponents through ModuleRecreator, possibly on another thread and after this
+    /// System is gone; without one it can only be copied from, and WorldBase::snapshot falls back to
+    /// recreatePartialComponents
+    std::unique_ptr<IModuleColumn> snapshotModules(const std::vector<EntityID>* eids) const {
+        if constexpr (std::is_copy_constructible<Instance>::value) {
+            typename ModuleColumn<Template, Instance>::Recreator recreator = nullptr;
+            if constexpr (ModuleRecreator<Template, Instance>::supported) recreator = &ModuleRecreator<Template, Instance>::recreate;
+            auto out = std::make_unique<ModuleColumn<Template, Instance>>(TYPE, recreator);
+
+            if (eids == nullptr) {
+                out->reserve(modules.size());
+                for (auto& m : modules) out->push(m.first, slots.at(m.first).type, *m.second);
+            }
+            else {
+                out->reserve(eids->size());
+                for (EntityID eID : *eids) {
+                    auto it = modules.find(eID);
+                    if (it != modules.end()) out->push(eID, slots.at(eID).type, *it->second);
+                }
+            }
+
+            return out;
+        }
+        else {
+            return nullptr;
+        }
+    }
+
+    bool loadColumn(const IModuleColumn& column, const std::unordered_map<EntityID, EntityID>* eidMapping) {
+        if (eidMapping != nullptr && !rawCopyModules<Template, Instance>) return false;
+
+        const ModuleColumn<Template, Instance>* typed = dynamic_cast<const ModuleColumn<Template, Instance>*>(&column);
+        if (typed == nullptr) return false;
+
+        modules.reserve(modules.size() + typed->size());
+        slots.reserve(slots.size() + typed->size());
+        awake.reserve(awake.size() + typed->size());
+        moduleToEID.reserve(moduleToEID.size() + typed->size());
+
+        for (std::size_t i = 0; i < typed->size(); i++) {
+            EntityID eID = eidMapping ? eidMapping->at(typed->eids[i]) : typed->eids[i];
+            insertModule(eID, std::make_unique<Instance>(typed->instances[i]), typed->moduleTypes[i]);
+        }
+
+        return true;
+    }
+
+    bool canEncodeModules() const {
+        return JournalCodec<Instance>::supported;
+    }
+
+    bool encodeModules(EntityID eID, std::vector<char>& out) const {
+        if constexpr (JournalCodec<Instance>::supported) {
+            auto it = modules.find(eID);
+            if (it == modules.end()) return false;
+
+            JournalCodec<Instance>::encode(*it->second, out);
+            return true;
+        }
+        else {
+            return false;
+        }
+    }
+
+    bool decodeModules(EntityID eID, const char* data, std::size_t size) {
+        if constexpr (JournalCodec<Instance>::supported) {
+            eraseModule(eID);
+            insertModule(eID, std::make_unique<Instance>(JournalCodec<Instance>::decode(data, size)), TYPE);
+            refreshEntitySlot(eID);
+            return true;
+        }
+        else {
+            return false;
+        }
+    }
 };
 
 ///0-N modules per entity
 template <class Template, class Instance, SystemType TYPE, class ...UpdateInputs>
 class MultiSystem : public ISystem<Template> {
-    std::unordered_map<EntityID, SystemType> moduleTypes;
+    std::unordered_map<EntityID, ModuleSlot> slots;
     std::unordered_map<Instance*, EntityID> moduleToEID;
+    ///entities with modules here that are awake
+    std::vector<EntityID> awake;
+
+    void eraseSlot(EntityID eID) {
+        auto it = slots.find(eID);
+        if (it == slots.end()) return;
+
+        removeAwake(it->second);
+        slots.erase(it);
+    }
+
+    void removeAwake(ModuleSlot& slot) {
+        if (slot.awakeIndex < 0) return;
+
+        awake[slot.awakeIndex] = awake.back();
+        slots.at(awake[slot.awakeIndex]).awakeIndex = slot.awakeIndex;
+        awake.pop_back();
+        slot.awakeIndex = -1;
+    }
+
+    ///so an Entity's cached slot for this System doesn't outlive its modules
+    void clearEntitySlot(EntityID eID) {
+        Entity* e = getEntity(eID);
+        if (e != nullptr) refreshModuleSlot(*e, TYPE, nullptr);
+    }
+
     protected:
     const std::function<Entity*(EntityID)> getEntity;
 
@@ -198,30 +802,72 @@ class MultiSystem : public ISystem<Template> {
 
 
     virtual std::unique_ptr<Instance> instantiateTemplate(const Template& t) =0;
+    ///override alongside the const& version when an Instance can take over a Template's resources
+    virtual std::unique_ptr<Instance> instantiateTemplate(Template&& t) {
+        return instantiateTemplate(static_cast<const Template&>(t));
+    }
 
     virtual std::shared_ptr<PartialComponent<Template>> _recreatePartialComponent(const Instance& i, SystemType st) const =0;
 
     virtual void customUpdate(UpdateInputs... ui) =0;
 
+    ///mID < 0 picks the next free ModuleID
+    void insertModule(EntityID eID, std::unique_ptr<Instance>&& instance, SystemType st, int mID = -1) {
+        if (mID < 0) {
+            mID = 0;
+            for (auto& pair : modules[eID]) mID = std::max(mID, pair.first.ID + 1);
+        }
+
+        Instance* m = instance.get();
+        modules[eID].insert(std::make_pair(ModuleID(mID), std::move(instance)));
+
+        auto slot = slots.find(eID);
+        if (slot == slots.end()) {
+            slots[eID] = ModuleSlot{st, (int) awake.size()};
+            awake.push_back(eID);
+        }
+        else {
+            slot->second.type = st;
+        }
+
+        moduleToEID.insert(std::pair<Instance*, EntityID>(m, eID));
+        this->notifyCreated(eID);
+    }
+
     public:
+    static constexpr SystemType Type = TYPE;
+    static constexpr bool SingleModule = false;
+    typedef Template TemplateType;
+    typedef Instance InstanceType;
+
     MultiSystem(std::function<Entity*(EntityID)> _idToEntity)
         : getEntity(_idToEntity) {}
 
     virtual ~MultiSystem() {}
 
     void update(UpdateInputs... ui) {
-        customUpdate(ui...);
+        customUpdate(std::forward<UpdateInputs>(ui)...);
     }
 
     void createModule(EntityID eID, const Template& t, SystemType st) {
-        int newMID = 0;
-        for (auto& pair : modules[eID]) newMID = std::max(newMID, pair.first.ID);
+        insertModule(eID, instantiateTemplate(t), st);
+    }
 
-        modules[eID].insert(std::make_pair<ModuleID, std::unique_ptr<Instance>>(ModuleID(newMID), std::move(instantiateTemplate(t))));
-        moduleTypes[eID] = st;
+    void createModule(EntityID eID, Template&& t, SystemType st) {
+        insertModule(eID, instantiateTemplate(std::move(t)), st);
+    }
 
-        Instance* m = modules[eID].at(modules[eID].size()-1).get();
-        moduleToEID.insert(std::pair<Instance*, EntityID>(m, eID));
+    ///non-virtual creation path for worlds that know the concrete System type at compile time (see StaticWorld)
+    /// falls back to the virtual call if Derived's instantiateTemplate isn't public
+    template <class Derived>
+    void createModuleStatic(EntityID eID, const Template& t, SystemType st) {
+        Derived& d = *static_cast<Derived*>(this);
+        if constexpr (requires { d.Derived::instantiateTemplate(t); }) {
+            insertModule(eID, d.Derived::instantiateTemplate(t), st);
+        }
+        else {
+            insertModule(eID, instantiateTemplate(t), st);
+        }
     }
 
     SystemType getType() const {
@@ -232,24 +878,109 @@ class MultiSystem : public ISystem<Template> {
         preDestroy(eID);
 
         if (modules.count(eID)) {
+            this->notifyDestroyed(eID);
+            clearEntitySlot(eID);
             for (auto& pair : modules.at(eID)) {
                 moduleToEID.erase(pair.second.get());
             }
         }
 
         modules.erase(eID);
-        moduleTypes.erase(eID);
+        eraseSlot(eID);
 
     }
 
+    bool removeModule(EntityID eID) {
+        auto it = modules.find(eID);
+        if (it == modules.end()) return true;
+
+        //hooks first, while the modules are still there to read, then observers, like removeModule(eID, mID)
+        for (auto& pair : it->second) preRemove(eID, pair.first);
+
+        this->notifyDestroyed(eID);
+        clearEntitySlot(eID);
+        for (auto& pair : it->second) moduleToEID.erase(pair.second.get());
+
+        modules.erase(it);
+        eraseSlot(eID);
+        return true;
+    }
+
+    bool removeModule(EntityID eID, ModuleID mID) {
+        auto it = modules.find(eID);
+        if (it == modules.end()) return true;
+
+        auto m = it->second.find(mID);
+        if (m != it->second.end()) {
+            preRemove(eID, mID);
+            moduleToEID.erase(m->second.get());
+            it->second.erase(m);
+
+            //the entity's remaining modules changed
+            if (!it->second.empty()) this->notifyModified(eID);
+        }
+
+        if (!it->second.empty()) return false;
+
+        this->notifyDestroyed(eID);
+        clearEntitySlot(eID);
+        modules.erase(it);
+        eraseSlot(eID);
+        return true;
+    }
+
+    bool hasModules(EntityID eID) const {
+        return has(eID);
+    }
+
+    std::vector<ModuleID> getModuleIDs(EntityID eID) const {
+        std::vector<ModuleID> out;
+        if (!modules.count(eID)) return out;
+
+        for (auto& pair : modules.at(eID)) out.push_back(pair.first);
+        return out;
+    }
+
     virtual void preDestroy(EntityID eID) {}
+    ///called before a module is removed from a live entity (WorldBase::removeComponent)
+    virtual void preRemove(EntityID eID, ModuleID mID) {}
+
+    ///override to count heap memory owned by an Instance (vectors, strings, ...)
+    virtual std::size_t instanceHeapBytes(const Instance& i) const { return 0; }
+
+    MemoryReport memoryReport() const {
+        MemoryReport out(std::string("MultiSystem ") + std::to_string(TYPE));
+
+        std::size_t inner = 0;
+        std::size_t instances = 0;
+        for (auto& m : modules) {
+            inner += hashContainerBytes(m.second);
+            for (auto& i : m.second) instances += sizeof(Instance) + instanceHeapBytes(*i.second);
+        }
+
+        out.add("modules", hashContainerBytes(modules));
+        out.add("modules (per entity)", inner);
+        out.add("slots", hashContainerBytes(slots));
+        out.add("awake", vectorBytes(awake));
+        out.add("moduleToEID", hashContainerBytes(moduleToEID));
+        out.add("instances", instances);
+        return out;
+    }
+
+    void compact() {
+        shrinkHashContainer(modules);
+        for (auto& m : modules) shrinkHashContainer(m.second);
+        shrinkHashContainer(slots);
+        shrinkVector(awake);
+        shrinkHashContainer(moduleToEID);
+    }
 
     EntityID moduleEID(Instance* ptr) {
         return moduleToEID.at(ptr);
     }
 
     std::shared_ptr<PartialComponent<Template>> recreatePartialComponent(const Instance& i, EntityID eID) const {
-        return _recreatePartialComponent(i, moduleTypes.at(eID));
+        return _recreatePartialComponent(i, slots.at(eID).type);
     }
 
     bool has(EntityID eID) const {
@@ -257,7 +988,47 @@ class MultiSystem : public ISystem<Template> {
         return modules.at(eID).size();
     }
 
+    ///tells observers (journals, indexes, ...) that one of eID's modules was written to
+    void touch(EntityID eID) {
+        this->notifyModified(eID);
+    }
+
+    ///func(Instance&), then touch
+    template <class F>
+    void modify(EntityID eID, ModuleID mID, F func) {
+        func(*modules.at(eID).at(mID));
+        touch(eID);
+    }
+
+    ///skips modules of sleeping entities (see WorldBase::sleep)
+    ///func may sleep its own entity; sleeping a different entity mid-loop can skip it this pass
     void applyFunctionToModules(std::function<void(EntityID, Entity&, Instance&)> func) {
+        for (std::size_t i = 0; i < awake.size();) {
+            EntityID eID = awake[i];
+            Entity* ePtr = getEntity(eID);
+            assert(ePtr != nullptr);
+
+            for (auto& j : modules.at(eID)) func(eID, *ePtr, *j.second);
+
+            if (i < awake.size() && awake[i] == eID) i++;
+        }
+    }
+
+    ///as applyFunctionToModules, with each module's ID (ex: to remove some afterwards)
+    void applyFunctionToModulesWithIDs(std::function<void(EntityID, ModuleID, Entity&, Instance&)> func) {
+        for (std::size_t i = 0; i < awake.size();) {
+            EntityID eID = awake[i];
+            Entity* ePtr = getEntity(eID);
+            assert(ePtr != nullptr);
+
+            for (auto& j : modules.at(eID)) func(eID, j.first, *ePtr, *j.second);
+
+            if (i < awake.size() && awake[i] == eID) i++;
+        }
+    }
+
+    ///includes sleeping entities
+    void applyFunctionToAllModules(std::function<void(EntityID, Entity&, Instance&)> func) {
         for (auto& i : modules) for (auto& j : i.second) {
             Entity* ePtr = getEntity(i.first);
             assert(ePtr != nullptr);
@@ -267,6 +1038,67 @@ class MultiSystem : public ISystem<Template> {
         }
     }
 
+    void setAwake(EntityID eID, bool isAwake) {
+        auto it = slots.find(eID);
+        if (it == slots.end() || isAwake == (it->second.awakeIndex >= 0)) return;
+
+        if (isAwake) {
+            it->second.awakeIndex = awake.size();
+            awake.push_back(eID);
+        }
+        else {
+            removeAwake(it->second);
+        }
+    }
+
+    std::size_t awakeCount() const { return awake.size(); }
+    std::size_t moduleCount() const { return moduleToEID.size(); }
+
+    ///amortized iteration: each call handles 1/slices of the modules (sized at the start of a pass),
+    /// so a full pass takes `slices` calls; returns true when a call finishes a pass
+    bool applyFunctionToModulesSliced(ModuleSlicer& slicer, std::size_t slices, std::function<void(EntityID, Entity&, Instance&)> func) {
+        assert(slices > 0);
+
+        return runModuleSlice(slicer, [&] (std::vector<EntityID>& pass) {
+            fillPass(pass);
+            slicer.perCall = (pass.size() + slices - 1) / slices;
+        }, [&] (EntityID eID) {
+            visitModules(eID, func);
+        }, [&] (std::size_t done) {
+            return done < slicer.perCall;
+        }, 1);
+    }
+
+    ///amortized iteration: stops once budgetSeconds have passed (checked every 16 entities) and resumes from there
+    /// on the next call; returns true when a call finishes a pass
+    bool applyFunctionToModulesBudgeted(ModuleSlicer& slicer, double budgetSeconds, std::function<void(EntityID, Entity&, Instance&)> func) {
+        auto start = std::chrono::steady_clock::now();
+
+        return runModuleSlice(slicer, [&] (std::vector<EntityID>& pass) {
+            fillPass(pass);
+        }, [&] (EntityID eID) {
+            visitModules(eID, func);
+        }, [&] (std::size_t) {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < budgetSeconds;
+        }, 16);
+    }
+
+    private:
+    void fillPass(std::vector<EntityID>& pass) const {
+        pass.assign(awake.begin(), awake.end());
+    }
+
+    void visitModules(EntityID eID, std::function<void(EntityID, Entity&, Instance&)>& func) {
+        auto it = modules.find(eID);
+        if (it == modules.end() || slots.at(eID).awakeIndex < 0) return;
+
+        Entity* ePtr = getEntity(eID);
+        assert(ePtr != nullptr);
+        for (auto& m : it->second) func(eID, *ePtr, *m.second);
+    }
+
+    public:
+
 
     std::vector<std::shared_ptr<IPartialComponent>> recreatePartialComponents(EntityID eid) {
         std::vector<std::shared_ptr<IPartialComponent>> out;
@@ -277,6 +1109,117 @@ class MultiSystem : public ISystem<Template> {
 
         return out;
     }
+
+    ///the column recreates PartialComponents through ModuleRecreator, possibly on another thread and after this
+    /// System is gone; without one it can only be copied from, and WorldBase::snapshot falls back to
+    /// recreatePartialComponents
+    std::unique_ptr<IModuleColumn> snapshotModules(const std::vector<EntityID>* eids) const {
+        if constexpr (std::is_copy_constructible<Instance>::value) {
+            typename ModuleColumn<Template, Instance>::Recreator recreator = nullptr;
+            if constexpr (ModuleRecreator<Template, Instance>::supported) recreator = &ModuleRecreator<Template, Instance>::recreate;
+            auto out = std::make_unique<ModuleColumn<Template, Instance>>(TYPE, recreator);
+
+            if (eids == nullptr) {
+                out->reserve(moduleToEID.size());
+                for (auto& e : modules) for (auto& m : e.second) out->push(e.first, slots.at(e.first).type, *m.second);
+            }
+            else {
+                for (EntityID eID : *eids) {
+                    auto it = modules.find(eID);
+                    if (it == modules.end()) continue;
+
+                    for (auto& m : it->second) out->push(eID, slots.at(eID).type, *m.second);
+                }
+            }
+
+            return out;
+        }
+        else {
+            return nullptr;
+        }
+    }
+
+    bool loadColumn(const IModuleColumn& column, const std::unordered_map<EntityID, EntityID>* eidMapping) {
+        if (eidMapping != nullptr && !rawCopyModules<Template, Instance>) return false;
+
+        const ModuleColumn<Template, Instance>* typed = dynamic_cast<const ModuleColumn<Template, Instance>*>(&column);
+        if (typed == nullptr) return false;
+
+        moduleToEID.reserve(moduleToEID.size() + typed->size());
+
+        for (std::size_t i = 0; i < typed->size(); i++) {
+            EntityID eID = eidMapping ? eidMapping->at(typed->eids[i]) : typed->eids[i];
+            insertModule(eID, std::make_unique<Instance>(typed->instances[i]), typed->moduleTypes[i]);
+        }
+
+        return true;
+    }
+
+    bool canEncodeModules() const {
+        return JournalCodec<Instance>::supported;
+    }
+
+    ///count, then (ModuleID, size, bytes) per module, in ModuleID order; the hash map's order depends on its
+    /// insertion history, and equal worlds must encode (and stateHash) the same
+    bool encodeModules(EntityID eID, std::vector<char>& out) const {
+        if constexpr (JournalCodec<Instance>::supported) {
+            auto it = modules.find(eID);
+            if (it == modules.end() || it->second.empty()) return false;
+
+            std::vector<std::pair<ModuleID, const Instance*>> sorted;
+            sorted.reserve(it->second.size());
+            for (auto& m : it->second) sorted.push_back(std::make_pair(m.first, m.second.get()));
+            std::sort(sorted.begin(), sorted.end(), [] (const auto& a, const auto& b) { return a.first < b.first; });
+
+            encodePOD<std::uint32_t>(sorted.size(), out);
+            for (auto& m : sorted) {
+                encodePOD<std::int32_t>(m.first.ID, out);
+
+                std::size_t sizeAt = out.size();
+                encodePOD<std::uint32_t>(0, out);
+                JournalCodec<Instance>::encode(*m.second, out);
+
+                std::uint32_t size = out.size() - sizeAt - sizeof(std::uint32_t);
+                std::memcpy(out.data() + sizeAt, &size, sizeof(size));
+            }
+            return true;
+        }
+        else {
+            return false;
+        }
+    }
+
+    bool decodeModules(EntityID eID, const char* data, std::size_t size) {
+        if constexpr (JournalCodec<Instance>::supported) {
+            destroyModulesQuietly(eID);
+
+            std::size_t offset = 0;
+            std::uint32_t count = decodePOD<std::uint32_t>(data, offset);
+            for (std::uint32_t i = 0; i < count; i++) {
+                int mID = decodePOD<std::int32_t>(data, offset);
+                std::uint32_t instanceSize = decodePOD<std::uint32_t>(data, offset);
+
+                insertModule(eID, std::make_unique<Instance>(JournalCodec<Instance>::decode(data + offset, instanceSize)), TYPE, mID);
+                offset += instanceSize;
+            }
+            return true;
+        }
+        else {
+            return false;
+        }
+    }
+
+    private:
+    ///drops eID's modules without preDestroy/preRemove
+    void destroyModulesQuietly(EntityID eID) {
+        auto it = modules.find(eID);
+        if (it == modules.end()) return;
+
+        this->notifyDestroyed(eID);
+        for (auto& pair : it->second) moduleToEID.erase(pair.second.get());
+        modules.erase(it);
+        eraseSlot(eID);
+    }
 };
 
 
@@ -284,6 +1227,34 @@ struct IComponent {
     virtual ~IComponent() {};
 };
 
+///a component already resolved against one World's System; see Prefab
+struct IBoundComponent {
+    virtual ~IBoundComponent() {};
+
+    virtual SystemBase& create(EntityID eID) const =0;
+    virtual SystemBase& getSystem() const =0;
+};
+
+template<class Template>
+class BoundComponent : public IBoundComponent {
+    ISystem<Template>& system;
+    Template t;
+    SystemType sysType;
+
+    public:
+    BoundComponent(ISystem<Template>& sys, const Template& _t, SystemType st)
+        : system(sys), t(_t), sysType(st) {}
+
+    SystemBase& create(EntityID eID) const {
+        system.createModule(eID, t, sysType);
+        return system;
+    }
+
+    SystemBase& getSystem() const {
+        return system;
+    }
+};
+
 struct IPartialComponent {
     virtual ~IPartialComponent() {};
 
@@ -292,8 +1263,30 @@ struct IPartialComponent {
     virtual std::shared_ptr<IPartialComponent> duplicateUpdate(const std::unordered_map<EntityID, EntityID>& eidMapping) {
         return std::shared_ptr<IPartialComponent>(nullptr);
     };
+
+    ///size of the most derived object, for memory reports
+    virtual std::size_t footprint() const =0;
+
+    ///does the System lookup and cast once, so the result can create modules repeatedly
+    virtual std::unique_ptr<IBoundComponent> bind(std::function<SystemBase&(SystemType)>& typeToSystem) const =0;
 };
 
+template<class Template>
+ISystem<Template>& castSystem(SystemBase& rawSys) {
+    ISystem<Template>* castedSys = dynamic_cast<ISystem<Template>*>(&rawSys);
+
+    if (castedSys == nullptr) {
+        std::string errorMsg = std::string("Failed to cast SystemBase to proper derived templated type System<");
+        errorMsg += std::string(typeid(Template).name());
+        errorMsg += std::string(">");
+        errorMsg += std::string("\n(from System type ")+std::string(typeid(rawSys).name())+std::string(")");
+
+        throw std::invalid_argument(errorMsg);
+    }
+
+    return *castedSys;
+}
+
 //pass these in Entity ctors to ensure Components are always coupled with valid IDs
 template<class Template>
 class PartialComponent : public IPartialComponent {
@@ -303,24 +1296,29 @@ class PartialComponent : public IPartialComponent {
 
     public:
     PartialComponent(Template _t, SystemType st)
-        : t(_t), sysType(st) {}
+        : t(std::move(_t)), sysType(st) {}
     virtual ~PartialComponent() {}
 
+    const Template& getTemplate() const { return t; }
+    SystemType getSystemType() const { return sysType; }
+
+    ISystem<Template>& resolve(std::function<SystemBase&(SystemType)>& typeToSystem) const {
+        return castSystem<Template>(typeToSystem(sysType));
+    }
+
     SystemBase& operator()(EntityID eID, std::function<SystemBase&(SystemType)>& typeToSystem) const {
-        SystemBase& rawSys = typeToSystem(sysType);
-        ISystem<Template>* castedSys = dynamic_cast<ISystem<Template>*>(&rawSys);
+        ISystem<Template>& sys = resolve(typeToSystem);
 
-        if (castedSys == nullptr) {
-            std::string errorMsg = std::string("Failed to cast SystemBase to proper derived templated type System<");
-            errorMsg += std::string(typeid(Template).name());
-            errorMsg += std::string(">");
-            errorMsg += std::string("\n(from System type ")+std::string(typeid(rawSys).name())+std::string(")");
+        sys.createModule(eID, t, sysType);
+        return sys;
+    }
 
-            throw std::invalid_argument(errorMsg);
-        }
+    std::unique_ptr<IBoundComponent> bind(std::function<SystemBase&(SystemType)>& typeToSystem) const {
+        return std::make_unique<BoundComponent<Template>>(resolve(typeToSystem), t, sysType);
+    }
 
-        castedSys->createModule(eID, t, sysType);
-        return *castedSys;
+    std::size_t footprint() const {
+        return sizeof(*this);
     }
 };
 
@@ -341,9 +1339,13 @@ class SimpleSystem : public System<Instance, Instance, Type, UpdateInputs...> {
     std::unique_ptr<Instance> instantiateTemplate(const Instance& i) {
         return std::make_unique<Instance>(i);
     }
+    std::unique_ptr<Instance> instantiateTemplate(Instance&& i) {
+        return std::make_unique<Instance>(std::move(i));
+    }
     //std::shared_ptr<PartialComponent<Template>> _recreatePartialComponent(const Instance& i, SystemType st) const
+    ///snapshot columns recreate through ModuleRecreator, so override both or neither
     virtual std::shared_ptr<PartialComponent<Instance>> _recreatePartialComponent(const Instance& i, SystemType st) const {
-        return std::make_shared<PartialComponent<Instance>>(i, st);
+        return ModuleRecreator<Instance, Instance>::recreate(i, st);
     }
 };
 
@@ -357,23 +1359,168 @@ class SimpleMultiSystem : public MultiSystem<Instance, Instance, Type, UpdateInp
     std::unique_ptr<Instance> instantiateTemplate(const Instance& i) {
         return std::make_unique<Instance>(i);
     }
+    std::unique_ptr<Instance> instantiateTemplate(Instance&& i) {
+        return std::make_unique<Instance>(std::move(i));
+    }
     //std::shared_ptr<PartialComponent<Template>> _recreatePartialComponent(const Instance& i, SystemType st) const
+    ///snapshot columns recreate through ModuleRecreator, so override both or neither
     virtual std::shared_ptr<PartialComponent<Instance>> _recreatePartialComponent(const Instance& i, SystemType st) const {
-        return std::make_shared<PartialComponent<Instance>>(i, st);
+        return ModuleRecreator<Instance, Instance>::recreate(i, st);
     }
 };
 
-template <SystemType Type, class ...UpdateInputs>
-class TagSystem : public System<EmptyStruct, EmptyStruct, Type, UpdateInputs...> {
+///one bit per entity: the tag set is a dense bitset indexed by EntityID::slot, with no per-entity heap objects or map entries
+/// build entities with TypedEmptyPC/EmptyPC as before; saves hold the same PartialComponent<EmptyStruct>,
+/// so worlds can load saves made with the old map-based TagSystem and vice versa
+///query combinations through tags(), ex: (visible.tags() & team.tags()).forEach([&] (std::size_t s) { visible.idAt(s); })
+///slots are reused (see IDAllocator), so the bitset spans the most entities the World had at once, not every EID
+/// ever made; each tagged slot's generation is kept alongside it, so a deleted entity's ID doesn't match the next
+template <SystemType TYPE, class ...UpdateInputs>
+class TagSystem : public ISystem<EmptyStruct> {
+    protected:
+    const std::function<Entity*(EntityID)> getEntity;
+
+    TagSet set;
+    ///generation of the entity tagged in each slot; only meaningful where set has the slot's bit
+    std::vector<std::uint32_t> generations;
+
+    void tag(EntityID eID) {
+        assert(eID.ID >= 0);
+        if (has(eID)) return;
+        //a slot is only reused once its last entity is destroyed, which untags it
+        assert(!set.test(eID.slot()));
+
+        if (generations.size() <= eID.slot()) generations.resize(eID.slot() + 1, 0);
+        generations[eID.slot()] = eID.generation();
+        set.set(eID.slot());
+        this->notifyCreated(eID);
+    }
+
+    void untag(EntityID eID) {
+        if (!has(eID)) return;
+
+        this->notifyDestroyed(eID);
+        set.reset(eID.slot());
+    }
+
     public:
+    static constexpr SystemType Type = TYPE;
+    ///tags have no Instance to get
+    static constexpr bool SingleModule = false;
+    typedef EmptyStruct TemplateType;
+    typedef EmptyStruct InstanceType;
+
     TagSystem(std::function<Entity*(EntityID)> idToEntity)
-     : System<EmptyStruct, EmptyStruct, Type>(idToEntity) {}
+     : getEntity(idToEntity) {}
+
+    virtual ~TagSystem() {}
 
-    std::unique_ptr<EmptyStruct> instantiateTemplate(const EmptyStruct& es) {
-        return std::make_unique<EmptyStruct>();
+    void update(UpdateInputs... ui) {
+        customUpdate(std::forward<UpdateInputs>(ui)...);
     }
-    std::shared_ptr<PartialComponent<EmptyStruct>> _recreatePartialComponent(const EmptyStruct& es, SystemType st) const {
-        return std::make_shared<PartialComponent<EmptyStruct>>(EmptyStruct(), st);
+    virtual void customUpdate(UpdateInputs... ui) {}
+
+    void createModule(EntityID eID, const EmptyStruct& t, SystemType st) { tag(eID); }
+    void createModule(EntityID eID, EmptyStruct&& t, SystemType st) { tag(eID); }
+
+    template <class Derived>
+    void createModuleStatic(EntityID eID, const EmptyStruct& t, SystemType st) { tag(eID); }
+
+    SystemType getType() const { return TYPE; }
+
+    virtual void preDestroy(EntityID eID) {}
+    virtual void preRemove(EntityID eID) {}
+
+    void destroyEntityModules(EntityID eID) {
+        preDestroy(eID);
+        untag(eID);
+    }
+
+    bool removeModule(EntityID eID) {
+        if (!has(eID)) return true;
+
+        preRemove(eID);
+        untag(eID);
+        return true;
+    }
+
+    bool has(EntityID eID) const {
+        return eID.ID >= 0 && set.test(eID.slot()) && generations[eID.slot()] == eID.generation();
+    }
+    bool hasModules(EntityID eID) const { return has(eID); }
+
+    ///indexed by EntityID::slot; idAt turns a set bit back into an EntityID
+    const TagSet& tags() const { return set; }
+    std::size_t count() const { return set.count(); }
+    ///the entity tagged in slot, which must be set in tags()
+    EntityID idAt(std::size_t slot) const {
+        assert(set.test(slot));
+        return EntityID(std::uint32_t(slot), generations[slot]);
+    }
+
+    ///f(EntityID) for each tagged entity, in slot order
+    template <class F>
+    void forEach(F f) const {
+        set.forEach([&] (std::size_t i) { f(idAt(i)); });
+    }
+
+    ///for code written against System; tags carry no data, and sleeping entities aren't skipped
+    void applyFunctionToModules(std::function<void(EntityID, Entity&, EmptyStruct&)> func) {
+        EmptyStruct es;
+        set.forEach([&] (std::size_t i) {
+            Entity* ePtr = getEntity(idAt(i));
+            assert(ePtr != nullptr);
+            func(idAt(i), *ePtr, es);
+        });
+    }
+
+    std::vector<std::shared_ptr<IPartialComponent>> recreatePartialComponents(EntityID eid) {
+        std::vector<std::shared_ptr<IPartialComponent>> out;
+        if (has(eid)) out.push_back(std::make_shared<PartialComponent<EmptyStruct>>(EmptyStruct(), TYPE));
+        return out;
+    }
+
+    MemoryReport memoryReport() const {
+        MemoryReport out(std::string("TagSystem ") + std::to_string(TYPE));
+        out.add("bitset", set.bytes());
+        out.add("generations", vectorBytes(generations));
+        return out;
+    }
+
+    void compact() {
+        set.shrink();
+        generations.resize(std::min(generations.size(), set.extent()));
+        shrinkVector(generations);
+    }
+
+    ///same column type as a map-based System<EmptyStruct, EmptyStruct>, so snapshots move between the two
+    std::unique_ptr<IModuleColumn> snapshotModules(const std::vector<EntityID>* eids) const {
+        auto out = std::make_unique<ModuleColumn<EmptyStruct, EmptyStruct>>(TYPE, &ModuleRecreator<EmptyStruct, EmptyStruct>::recreate);
+
+        if (eids == nullptr) {
+            out->reserve(set.count());
+            set.forEach([&] (std::size_t i) { out->push(idAt(i), TYPE, EmptyStruct()); });
+        }
+        else {
+            for (EntityID eID : *eids) if (has(eID)) out->push(eID, TYPE, EmptyStruct());
+        }
+        return out;
+    }
+
+    bool loadColumn(const IModuleColumn& column, const std::unordered_map<EntityID, EntityID>* eidMapping) {
+        const ModuleColumn<EmptyStruct, EmptyStruct>* typed = dynamic_cast<const ModuleColumn<EmptyStruct, EmptyStruct>*>(&column);
+        if (typed == nullptr) return false;
+
+        for (EntityID eID : typed->eids) tag(eidMapping ? eidMapping->at(eID) : eID);
+        return true;
+    }
+
+    ///presence is the whole encoding
+    bool canEncodeModules() const { return true; }
+    bool encodeModules(EntityID eID, std::vector<char>& out) const { return has(eID); }
+    bool decodeModules(EntityID eID, const char* data, std::size_t size) {
+        tag(eID);
+        return true;
     }
 };
 
@@ -382,15 +1529,54 @@ class TagSystem : public System<EmptyStruct, EmptyStruct, Type, UpdateInputs...>
 template<class Template, SystemType type>
 class TypedPartialComponent : public PartialComponent<Template> {
     public:
+    static constexpr SystemType Type = type;
+    typedef Template TemplateType;
+
     TypedPartialComponent(Template t)
-        : PartialComponent<Template>(t, type) {}
+        : PartialComponent<Template>(std::move(t), type) {}
 };
 
 template<SystemType type>
 class TypedEmptyPC : public EmptyPC {
     public:
+    static constexpr SystemType Type = type;
+    typedef EmptyStruct TemplateType;
+
     TypedEmptyPC()
         : EmptyPC(type) {}
 };
 
+///emplace<SomeSystem>(args...): a component whose Template is built from args directly at entity creation,
+/// then moved into the Instance; no PartialComponent heap object or Template copies.
+///pass to WorldBase::makeEntity(placement, emplace<...>(...), ...); args are held by value until then
+template<class Sys, class... Args>
+class EmplaceComponent {
+    std::tuple<Args...> args;
+
+    public:
+    typedef typename Sys::TemplateType TemplateType;
+    static constexpr SystemType Type = Sys::Type;
+
+    EmplaceComponent(std::tuple<Args...>&& a)
+        : args(std::move(a)) {}
+
+    SystemBase& create(EntityID eID, SystemBase& rawSys) {
+        ISystem<TemplateType>& sys = castSystem<TemplateType>(rawSys);
+
+        sys.createModule(eID, std::make_from_tuple<TemplateType>(std::move(args)), Type);
+        return sys;
+    }
+};
+
+template<class Sys, class... Args>
+EmplaceComponent<Sys, std::decay_t<Args>...> emplace(Args&&... args) {
+    return EmplaceComponent<Sys, std::decay_t<Args>...>(std::tuple<std::decay_t<Args>...>(std::forward<Args>(args)...));
+}
+
+template<class T>
+struct isEmplaceComponent : std::false_type {};
+
+template<class Sys, class... Args>
+struct isEmplaceComponent<EmplaceComponent<Sys, Args...>> : std::true_type {};
+
 #endif // COMPONENT_H
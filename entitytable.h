@@ -0,0 +1,369 @@
+#pragma once
+
+#include <vector>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+
+#include "component.h"
+#include "actor.h"
+#include "perthread.h"
+
+///hands out EntityIDs to any number of threads: each thread takes a block of up to BlockSize IDs at a time, then
+/// allocates from it without synchronization. Blocks come from released slots (at their next generation) while there
+/// are any, under a mutex, and otherwise from fresh slots with one atomic add
+///a single thread gets consecutive IDs until slots are released; with several, IDs are unique but interleave in blocks
+class IDAllocator {
+    public:
+    static constexpr int BlockSize = 64;
+
+    IDAllocator()
+        : next(0), freedCount(0) {}
+
+    EntityID allocate() {
+        beginAllocate();
+        Block& b = blocks.local();
+        if (b.count == 0) refill(b);
+
+        EntityID out(b.ids[--b.count]);
+        endAllocate();
+        return out;
+    }
+
+    ///makes sure allocate() doesn't hand out eid's slot (ex: after loading eid) until eid is released; only a
+    /// block holding that slot changes
+    ///claim edits other threads' blocks, so no other thread may allocate meanwhile; debug builds assert that
+    void claim(EntityID eid) {
+        beginClaim();
+        std::uint32_t slot = eid.slot();
+        std::uint32_t current = next.load(std::memory_order_relaxed);
+        while (slot >= current) {
+            //no block holds it yet; the slots skipped over are never handed out
+            if (next.compare_exchange_weak(current, slot + 1, std::memory_order_relaxed)) {
+                endClaim();
+                return;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto sameSlot = [slot] (EntityID f) { return f.slot() == slot; };
+        freed.erase(std::remove_if(freed.begin(), freed.end(), sameSlot), freed.end());
+        freedCount.store(freed.size(), std::memory_order_release);
+
+        blocks.forEach([&] (Block& b) {
+            for (int i = 0; i < b.count; i++) {
+                if (!sameSlot(EntityID(b.ids[i]))) continue;
+                b.ids[i] = b.ids[--b.count];
+                break;
+            }
+        });
+        endClaim();
+    }
+
+    ///false while some thread is in allocate() or claim(); always true in release builds, so only use it in asserts
+    bool idle() const {
+#ifndef NDEBUG
+        return inUse.load() == 0;
+#else
+        return true;
+#endif
+    }
+
+    ///hands eid's slot back, to be reused at the next generation; call once eid is out of the EntityTable
+    void release(EntityID eid) {
+        std::lock_guard<std::mutex> lock(mutex);
+        freed.push_back(eid.reused());
+        freedCount.store(freed.size(), std::memory_order_release);
+    }
+
+    ///every slot handed out (or claimed) so far is below this
+    std::uint32_t bound() const { return next.load(std::memory_order_relaxed); }
+
+    std::size_t bytes() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return vectorBytes(freed) + blocks.bytes();
+    }
+
+    void shrink() {
+        std::lock_guard<std::mutex> lock(mutex);
+        shrinkVector(freed);
+    }
+
+    private:
+    struct Block {
+        ///handed out from the back
+        std::int64_t ids[BlockSize];
+        int count = 0;
+    };
+
+    std::atomic<std::uint32_t> next;
+    std::atomic<std::size_t> freedCount;
+    ///released slots, already at their next generation
+    std::vector<EntityID> freed;
+    std::mutex mutex;
+    PerThread<Block> blocks;
+
+#ifndef NDEBUG
+    ///allocate() calls in progress, plus Claiming while claim() runs
+    std::atomic<std::uint32_t> inUse{0};
+    static constexpr std::uint32_t Claiming = 1u << 31;
+
+    void beginAllocate() {
+        std::uint32_t before = inUse.fetch_add(1);
+        assert(!(before & Claiming) && "IDAllocator::allocate during claim (ex: makeEntityNextFrame during a load)");
+    }
+    void endAllocate() { inUse.fetch_sub(1); }
+    void beginClaim() {
+        std::uint32_t before = inUse.fetch_or(Claiming);
+        assert(before == 0 && "IDAllocator::claim while another thread is allocating");
+    }
+    void endClaim() { inUse.fetch_and(~Claiming); }
+#else
+    void beginAllocate() {}
+    void endAllocate() {}
+    void beginClaim() {}
+    void endClaim() {}
+#endif
+
+    void refill(Block& b) {
+        if (freedCount.load(std::memory_order_acquire) > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            while (b.count < BlockSize && !freed.empty()) {
+                b.ids[b.count++] = freed.back().ID;
+                freed.pop_back();
+            }
+            freedCount.store(freed.size(), std::memory_order_release);
+            if (b.count > 0) return;
+        }
+
+        std::uint32_t first = next.fetch_add(BlockSize, std::memory_order_relaxed);
+        for (int i = 0; i < BlockSize; i++) b.ids[i] = first + BlockSize - 1 - i;
+        b.count = BlockSize;
+    }
+};
+
+///WorldBase's entity storage: a segmented array indexed by EntityID for lookups, plus a dense list for iteration
+///get() is lock-free and safe from any thread while the update thread isn't inserting or erasing; WorldBase only
+/// does that in its Deletion/Creation phases and in (make|load|delete)Entity calls, so worker threads can look
+/// entities up freely during customUpdate
+///entities are indexed by EntityID::slot; a lookup checks the whole ID, so a deleted entity's ID doesn't find the
+/// next entity in its slot. Segments (and the directory pages pointing to them) are allocated on first use and never
+/// move, so a lookup is three dependent loads and a World only pays for the most slots it had in use at once
+/// (IDAllocator reuses released slots); up to 2^28 at once
+///the rest of the interface mirrors the unordered_map it replaced; iteration order is insertion order,
+/// with erase moving the last entity into the hole
+class EntityTable {
+    public:
+    typedef std::pair<EntityID, std::unique_ptr<Entity>> value_type;
+    typedef std::vector<value_type>::iterator iterator;
+    typedef std::vector<value_type>::const_iterator const_iterator;
+
+    static constexpr std::size_t SegmentBits = 12;
+    static constexpr std::size_t PageBits = 10;
+    static constexpr std::size_t Pages = 64;
+    static constexpr std::size_t SegmentSize = std::size_t(1) << SegmentBits;
+    static constexpr std::size_t PageSize = std::size_t(1) << PageBits;
+    static constexpr std::size_t MaxEntities = Pages * PageSize * SegmentSize;
+
+    EntityTable()
+        : pageCount(0), segmentCount(0) {}
+
+    ~EntityTable() {
+        dense.clear();
+
+        for (auto& p : pages) {
+            Page* page = p.load(std::memory_order_relaxed);
+            if (page == nullptr) continue;
+
+            for (auto& s : page->segments) delete s.load(std::memory_order_relaxed);
+            delete page;
+        }
+    }
+
+    EntityTable(const EntityTable&) = delete;
+    EntityTable& operator= (const EntityTable&) = delete;
+
+    ///nullptr if eid isn't in the table
+    Entity* get(EntityID eid) const {
+        Entity* e = getSlot(eid);
+        return e != nullptr && e->getID() == eid ? e : nullptr;
+    }
+
+    std::size_t count(EntityID eid) const { return get(eid) != nullptr; }
+    ///whether eid's slot is held, by eid or by an entity of another generation; insert(eid) fails if so
+    bool slotTaken(EntityID eid) const { return getSlot(eid) != nullptr; }
+
+    ///throws std::out_of_range if eid isn't in the table, like unordered_map::at
+    std::unique_ptr<Entity>& at(EntityID eid) {
+        if (get(eid) == nullptr) throw std::out_of_range("EntityTable::at: no entity " + std::to_string(eid.ID));
+        return dense[denseIndex(eid)].second;
+    }
+
+    iterator find(EntityID eid) {
+        return get(eid) == nullptr ? dense.end() : dense.begin() + denseIndex(eid);
+    }
+
+    ///the Entity is published to other threads' get() once it's fully in the table
+    ///throws std::invalid_argument if another entity holds eid's slot
+    std::pair<iterator, bool> insert(value_type&& entry) {
+        EntityID eid = entry.first;
+        if (!inRange(eid)) {
+            throw std::out_of_range("EntityTable::insert: EntityID " + std::to_string(eid.ID) + " is out of range");
+        }
+        if (Entity* held = getSlot(eid)) {
+            if (held->getID() == eid) return std::make_pair(find(eid), false);
+            throw std::invalid_argument("EntityTable::insert: EntityID " + std::to_string(eid.ID) + "'s slot is held by "
+                                        + std::to_string(held->getID().ID));
+        }
+
+        Segment& s = segment(eid);
+
+        Entity* e = entry.second.get();
+        s.dense[slotOf(eid)] = dense.size();
+        dense.push_back(std::move(entry));
+        s.entities[slotOf(eid)].store(e, std::memory_order_release);
+
+        return std::make_pair(dense.end() - 1, true);
+    }
+
+    ///destroys the Entity; invalidates iterators to it and to the last entity
+    void erase(iterator it) {
+        EntityID eid = it->first;
+        std::size_t index = it - dense.begin();
+
+        segment(eid).entities[slotOf(eid)].store(nullptr, std::memory_order_release);
+
+        if (index + 1 != dense.size()) {
+            dense[index] = std::move(dense.back());
+            segment(dense[index].first).dense[slotOf(dense[index].first)] = index;
+        }
+        dense.pop_back();
+    }
+
+    iterator begin() { return dense.begin(); }
+    iterator end() { return dense.end(); }
+    const_iterator begin() const { return dense.begin(); }
+    const_iterator end() const { return dense.end(); }
+
+    std::size_t size() const { return dense.size(); }
+    bool empty() const { return dense.empty(); }
+    void reserve(std::size_t n) { dense.reserve(n); }
+
+    ///shrinks the dense list if a load spike left it oversized; segments stay, since concurrent readers may hold them
+    bool shrink() { return shrinkVector(dense); }
+
+    std::size_t bytes() const {
+        return sizeof(pages) + pageCount * sizeof(Page) + segmentCount * sizeof(Segment) + vectorBytes(dense);
+    }
+
+    private:
+    struct Segment {
+        std::atomic<Entity*> entities[SegmentSize] = {};
+        ///index into dense; only used by the update thread
+        std::uint32_t dense[SegmentSize] = {};
+    };
+
+    struct Page {
+        std::atomic<Segment*> segments[PageSize] = {};
+    };
+
+    std::atomic<Page*> pages[Pages] = {};
+    std::size_t pageCount;
+    std::size_t segmentCount;
+    std::vector<value_type> dense;
+
+    static bool inRange(EntityID eid) { return eid.ID >= 0 && eid.slot() < MaxEntities; }
+    static std::size_t pageOf(EntityID eid) { return std::size_t(eid.slot()) >> (SegmentBits + PageBits); }
+    static std::size_t segmentOf(EntityID eid) { return (std::size_t(eid.slot()) >> SegmentBits) & (PageSize - 1); }
+    static std::size_t slotOf(EntityID eid) { return std::size_t(eid.slot()) & (SegmentSize - 1); }
+
+    ///whatever entity is in eid's slot, of any generation
+    Entity* getSlot(EntityID eid) const {
+        if (!inRange(eid)) return nullptr;
+
+        Page* p = pages[pageOf(eid)].load(std::memory_order_acquire);
+        if (p == nullptr) return nullptr;
+        Segment* s = p->segments[segmentOf(eid)].load(std::memory_order_acquire);
+        if (s == nullptr) return nullptr;
+        return s->entities[slotOf(eid)].load(std::memory_order_acquire);
+    }
+
+    std::size_t denseIndex(EntityID eid) const {
+        Page* p = pages[pageOf(eid)].load(std::memory_order_relaxed);
+        return p->segments[segmentOf(eid)].load(std::memory_order_relaxed)->dense[slotOf(eid)];
+    }
+
+    ///allocates eid's page and segment if they don't exist yet; update thread only
+    Segment& segment(EntityID eid) {
+        std::atomic<Page*>& pageSlot = pages[pageOf(eid)];
+
+        Page* p = pageSlot.load(std::memory_order_relaxed);
+        if (p == nullptr) {
+            p = new Page();
+            pageCount++;
+            pageSlot.store(p, std::memory_order_release);
+        }
+
+        std::atomic<Segment*>& segmentSlot = p->segments[segmentOf(eid)];
+
+        Segment* s = segmentSlot.load(std::memory_order_relaxed);
+        if (s == nullptr) {
+            s = new Segment();
+            segmentCount++;
+            segmentSlot.store(s, std::memory_order_release);
+        }
+        return *s;
+    }
+};
+
+///makeEntityNextFrame's queue: each thread appends to its own buffer, and the update thread merges them (in EID order)
+/// at the start of the Creation phase
+class CreationQueue {
+    public:
+    struct Entry {
+        EntityID eID;
+        std::vector<std::shared_ptr<IPartialComponent>> components;
+        Placement p;
+    };
+
+    void push(Entry&& e) {
+        buffers.local().push_back(std::move(e));
+    }
+
+    ///moves every thread's entries into out, sorted by EID; call only at frame boundaries
+    void collect(std::vector<Entry>& out) {
+        buffers.forEach([&] (std::vector<Entry>& b) {
+            std::move(b.begin(), b.end(), std::back_inserter(out));
+            b.clear();
+        });
+
+        std::sort(out.begin(), out.end(), [] (const Entry& a, const Entry& b) { return a.eID < b.eID; });
+    }
+
+    void shrink() {
+        buffers.forEach([] (std::vector<Entry>& b) { shrinkVector(b); });
+    }
+
+    std::size_t bytes() {
+        std::size_t out = buffers.bytes();
+        buffers.forEach([&] (const std::vector<Entry>& b) {
+            out += vectorBytes(b);
+            for (auto& e : b) {
+                out += vectorBytes(e.components);
+                for (auto& pc : e.components) out += pc->footprint();
+            }
+        });
+        return out;
+    }
+
+    private:
+    PerThread<std::vector<Entry>> buffers;
+};
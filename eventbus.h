@@ -0,0 +1,128 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <typeindex>
+#include <unordered_map>
+
+#include "component.h"
+#include "perthread.h"
+
+///typed, batched events between Systems, ex:
+///  struct DamageEvent { EntityID eID; double amount; };
+///  world.eventChannel<DamageEvent>().emit(DamageEvent{target, 5.});       //any thread, any time during a frame
+///  world.eventChannel<DamageEvent>().drainSortedByEntity(applyDamageBatch); //next frame
+///events emitted during frame N are published in one contiguous buffer at the start of frame N+1's update;
+/// anything not drained by the end of N+1 is dropped
+
+class IEventChannel {
+    public:
+    virtual ~IEventChannel() {}
+
+    ///merges every producer thread's buffer into the published buffer; call only at frame boundaries
+    virtual void publish() =0;
+    virtual MemoryReport memoryReport() const =0;
+};
+
+template <class Event>
+class EventChannel : public IEventChannel {
+    struct ThreadBuffer {
+        std::vector<Event> events;
+    };
+
+    ///each producer thread writes to its own buffer
+    PerThread<ThreadBuffer> buffers;
+
+    std::vector<Event> published;
+    ///drainSortedByEntity's scratch, kept between frames
+    std::vector<std::pair<EntityID, std::size_t>> order;
+    std::vector<Event> sorted;
+
+    public:
+    void emit(const Event& e) {
+        buffers.local().events.push_back(e);
+    }
+
+    template <class... Args>
+    void emplace(Args&&... args) {
+        buffers.local().events.emplace_back(std::forward<Args>(args)...);
+    }
+
+    void publish() {
+        published.clear();
+
+        buffers.forEach([&] (ThreadBuffer& b) {
+            published.insert(published.end(), b.events.begin(), b.events.end());
+            b.events.clear();
+        });
+    }
+
+    ///events published this frame
+    const std::vector<Event>& events() const { return published; }
+
+    ///hands the whole batch to func, then clears it
+    template <class F>
+    void drain(F func) {
+        func(static_cast<const std::vector<Event>&>(published));
+        published.clear();
+    }
+
+    ///as drain, but ordered by Event::eID (stable, so one entity's events keep their emission order)
+    ///(sorts (eID, emission index) keys in place and gathers into a reused buffer; std::stable_sort would allocate
+    /// a temporary buffer every call)
+    template <class F>
+    void drainSortedByEntity(F func) {
+        order.clear();
+        for (std::size_t i = 0; i < published.size(); i++) order.push_back(std::make_pair(published[i].eID, i));
+        std::sort(order.begin(), order.end());
+
+        sorted.clear();
+        for (auto& o : order) sorted.push_back(published[o.second]);
+        published.swap(sorted);
+        drain(func);
+    }
+
+    MemoryReport memoryReport() const {
+        MemoryReport out(std::string("EventChannel<") + typeid(Event).name() + ">");
+
+        std::size_t threadBytes = buffers.bytes();
+        buffers.forEach([&] (const ThreadBuffer& b) { threadBytes += vectorBytes(b.events); });
+
+        out.add("thread buffers", threadBytes);
+        out.add("published", vectorBytes(published));
+        out.add("sort scratch", vectorBytes(order) + vectorBytes(sorted));
+        return out;
+    }
+};
+
+///owns one EventChannel per event type
+///channels are created on first use; create them on the update thread before emitting from workers
+class EventBus {
+    std::unordered_map<std::type_index, std::unique_ptr<IEventChannel>> channels;
+
+    public:
+    template <class Event>
+    EventChannel<Event>& channel() {
+        auto it = channels.find(std::type_index(typeid(Event)));
+        if (it == channels.end()) {
+            it = channels.emplace(std::type_index(typeid(Event)), std::make_unique<EventChannel<Event>>()).first;
+        }
+
+        return static_cast<EventChannel<Event>&>(*it->second);
+    }
+
+    void publish() {
+        for (auto& c : channels) c.second->publish();
+    }
+
+    MemoryReport memoryReport() const {
+        MemoryReport out("EventBus");
+        out.add("channels", hashContainerBytes(channels));
+        for (auto& c : channels) out.children.push_back(c.second->memoryReport());
+        return out;
+    }
+};
@@ -1,73 +1,6 @@
-#include "worldbase.h"
+#include "examplegame.h"
 #include <iostream>
 
-///for now, this just demonstrates how these are constructed
-/// todo: make something like a simple text-based pacman game to better demonstrate
-
-struct HealthValue {
-    double maxHealth;
-    double curHealth;
-
-    HealthValue(double maxHP)
-        : maxHealth(maxHP), curHealth(maxHP) {}
-};
-
-typedef TypedPartialComponent<HealthValue, SystemType::Health> HealthPC;
-
-class ExampleGameWorld;
-
-class HealthSystem : public SimpleSystem<HealthValue, SystemType::Health> {
-    public:
-    HealthSystem(std::function<Entity*(EntityID)> idToEntity, ExampleGameWorld& gw)
-     : SimpleSystem(idToEntity), world(gw) {}
-
-    void customUpdate();
-
-    const HealthValue& get(EntityID eID) {
-        assert(modules.count(eID));
-        return *modules.at(eID);
-    }
-
-    void applyDamage(EntityID eID, double damage) {
-        modules.at(eID)->curHealth -= damage;
-    }
-
-    private:
-    ExampleGameWorld& world;
-};
-
-class ExampleGameWorld : public WorldBase {
-    public:
-    ExampleGameWorld();
-
-    void customUpdate(double deltaTime);
-
-    HealthSystem healthSystem;
-	//...
-};
-
-#define ID2ENT getIDToEntityFunc()
-
-ExampleGameWorld::ExampleGameWorld()
-    : WorldBase({healthSystem}),
-      healthSystem(ID2ENT, *this) /*, xSystem(ID2ENT, arg0, arg1), ...*/ {}
-
-void ExampleGameWorld::customUpdate(double deltaTime) {
-    healthSystem.update();
-
-	//xSystem.update(arg0, arg1, ...)
-	//ySystem.update(a, b, ...)
-	//...
-}
-
-void HealthSystem::customUpdate() {
-	auto updateFunc = [&] (EntityID eID, Entity& e, HealthValue& v) {
-    	if (v.curHealth <= 0.0 + 0.00001) world.deleteEntityNextFrame(eID);
-	};
-
-	applyFunctionToModules(updateFunc);
-}
-
 
 
 /*
@@ -89,7 +22,15 @@ int main() {
 
 	world.update(1.0);
 
-	std::cout<<world.getEntity(e0).pos<<std::endl;
+	world.eventChannel<DamageEvent>().emit(DamageEvent{e0, 5.});
+	world.update(1.0);
+
+	Entity& entity0 = world.getEntity(e0);
+	std::cout<<entity0.pos<<" "<<entity0.get<HealthSystem>().curHealth<<std::endl;
+
+	std::cout<<world.memoryReport();
+	if (AllocationCounter::enabled()) std::cout<<"frame allocations: "<<world.lastFrameAllocations().total()<<std::endl;
+	else std::cout<<"frame allocations: allocation counting disabled (build with -DWEDGE_COUNT_ALLOCATIONS)"<<std::endl;
 
 	world.healthSystem.destroyEntityModules(e0);
 
@@ -0,0 +1,45 @@
+#include "examplegame.h"
+
+#define ID2ENT getIDToEntityFunc()
+
+ExampleGameWorld::ExampleGameWorld()
+    : WorldBase({healthSystem, buffSystem}),
+      healthSystem(ID2ENT, *this), buffSystem(ID2ENT, *this) /*, xSystem(ID2ENT, arg0, arg1), ...*/ {}
+
+void ExampleGameWorld::customUpdate(double deltaTime) {
+    healthSystem.update();
+    buffSystem.update(deltaTime);
+
+	//xSystem.update(arg0, arg1, ...)
+	//ySystem.update(a, b, ...)
+	//...
+}
+
+void HealthSystem::customUpdate() {
+	world.eventChannel<DamageEvent>().drainSortedByEntity([&] (const std::vector<DamageEvent>& batch) {
+		for (auto& d : batch) {
+			Entity* e = getEntity(d.eID);
+			if (e != nullptr && e->tryGet<HealthSystem>() != nullptr) applyDamage(*e, d.amount);
+		}
+	});
+
+	byHealth.forEachUpTo(0.0 + 0.00001, [&] (EntityID eID, double curHealth) {
+		world.deleteEntityNextFrame(eID);
+	});
+}
+
+void BuffSystem::customUpdate(double deltaTime) {
+	//modules can't be removed mid-iteration, so expired ones are collected first
+	expired.clear();
+
+	//sleeping entities' buffs are paused along with them
+	applyFunctionToModulesWithIDs([&] (EntityID eID, ModuleID mID, Entity& e, BuffValue& b) {
+		world.eventChannel<DamageEvent>().emit(DamageEvent{eID, b.damagePerSecond * deltaTime});
+		b.remaining -= deltaTime;
+		//so the journal, stateHash and FrontBuffers see the countdown
+		touch(eID);
+		if (b.remaining <= 0.) expired.push_back(std::make_pair(eID, mID));
+	});
+
+	world.removeComponents(SystemType::Buffs, expired);
+}
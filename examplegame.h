@@ -0,0 +1,81 @@
+#pragma once
+
+#include "worldbase.h"
+#include "fieldindex.h"
+
+///for now, this just demonstrates how these are constructed
+/// todo: make something like a simple text-based pacman game to better demonstrate
+///shared by example.cpp and soak.cpp
+
+struct HealthValue {
+    double maxHealth;
+    double curHealth;
+
+    HealthValue(double maxHP)
+        : maxHealth(maxHP), curHealth(maxHP) {}
+};
+
+typedef TypedPartialComponent<HealthValue, SystemType::Health> HealthPC;
+template<> struct RawModuleCopy<HealthValue> : std::true_type {};
+
+struct DamageEvent {
+    EntityID eID;
+    double amount;
+};
+
+class ExampleGameWorld;
+
+class HealthSystem : public SimpleSystem<HealthValue, SystemType::Health> {
+    public:
+    HealthSystem(std::function<Entity*(EntityID)> idToEntity, ExampleGameWorld& gw)
+     : SimpleSystem(idToEntity), world(gw), byHealth(*this, [] (const HealthValue& h) { return h.curHealth; }) {}
+
+    void customUpdate();
+
+    const HealthValue& get(EntityID eID) {
+        assert(modules.count(eID));
+        return *modules.at(eID);
+    }
+
+    void applyDamage(Entity& e, double damage) {
+        e.get<HealthSystem>().curHealth -= damage;
+        touch(e.getID());
+    }
+
+    private:
+    ExampleGameWorld& world;
+    ///finds the dead without scanning every module; applyDamage touches, so it stays current
+    FieldIndex<SimpleSystem<HealthValue, SystemType::Health>, double> byHealth;
+};
+
+///timed damage-over-time effects; an entity can carry any number (a MultiSystem example)
+struct BuffValue {
+    double damagePerSecond;
+    double remaining;
+};
+
+typedef TypedPartialComponent<BuffValue, SystemType::Buffs> BuffPC;
+template<> struct RawModuleCopy<BuffValue> : std::true_type {};
+
+class BuffSystem : public SimpleMultiSystem<BuffValue, SystemType::Buffs, double> {
+    public:
+    BuffSystem(std::function<Entity*(EntityID)> idToEntity, ExampleGameWorld& gw)
+     : SimpleMultiSystem(idToEntity), world(gw) {}
+
+    void customUpdate(double deltaTime);
+
+    private:
+    ExampleGameWorld& world;
+    std::vector<std::pair<EntityID, ModuleID>> expired;
+};
+
+class ExampleGameWorld : public WorldBase {
+    public:
+    ExampleGameWorld();
+
+    void customUpdate(double deltaTime);
+
+    HealthSystem healthSystem;
+    BuffSystem buffSystem;
+	//...
+};
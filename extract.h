@@ -0,0 +1,149 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+
+#include "3dmath.h"
+#include "component.h"
+#include "actor.h"
+
+///how WorldBase::extract writes each entity's transform
+enum class TransformFormat {
+    ///7 floats: position x, y, z, then rotation quaternion x, y, z, w
+    PosQuat,
+    ///16 floats: column-major 4x4 matrix (glm/OpenGL layout)
+    Matrix
+};
+
+enum class ExtractMode {
+    ///every entity
+    All,
+    ///only entities whose record may differ from the last extract call: created, moving (or moving then),
+    /// put to sleep, or with a field's module created/touch()ed/destroyed; see Extractor::removed for deletions
+    Changed
+};
+
+///record layout for WorldBase::extract, which fills a caller-provided buffer (ex: a mapped GPU instance buffer)
+/// with one stride-byte record per entity: the interpolated transform at transformOffset, plus any fields, ex:
+///  Extractor x(TransformFormat::PosQuat, 32);
+///  x.field<HealthSystem>(28, [] (const HealthValue& h) { return float(h.curHealth); });
+///  world.setExtractor(&x);
+///  std::size_t n = world.extract(buffer.data(), eids.data(), capacity, ExtractMode::Changed);
+///fields are for Systems with one Instance per entity; entities without the module get a value-initialized field
+///records aren't padded or aligned beyond what stride and the offsets give them; values are copied in with memcpy
+class Extractor : public ModuleObserver {
+    public:
+    Extractor(TransformFormat f, std::size_t recordStride, std::size_t transformBytesOffset = 0)
+        : format(f), stride(recordStride), transformOffset(transformBytesOffset), attached(false) {
+        checkFits(transformOffset, transformBytes(), "transform");
+    }
+
+    Extractor(const Extractor&) = delete;
+    Extractor& operator= (const Extractor&) = delete;
+
+    ///writes project(module) (any trivially copyable type) at offset in each record; add fields before setExtractor
+    template <class Sys, class F>
+    Extractor& field(std::size_t offset, F project) {
+        static_assert(Sys::SingleModule, "Extractor fields need a System with one Instance per entity");
+        typedef typename Sys::InstanceType Instance;
+        typedef std::decay_t<decltype(project(std::declval<const Instance&>()))> T;
+        static_assert(std::is_trivially_copyable<T>::value, "Extractor fields are memcpy'd into records");
+
+        assert(!attached && "add Extractor fields before WorldBase::setExtractor");
+        checkFits(offset, sizeof(T), "field");
+
+        fieldTypes.push_back(Sys::Type);
+        fields.push_back([offset, project] (Entity& e, char* record) {
+            const Instance* m = e.tryGet<Sys>();
+            T value = m != nullptr ? T(project(*m)) : T();
+            std::memcpy(record + offset, &value, sizeof(T));
+        });
+        return *this;
+    }
+
+    std::size_t recordBytes() const { return stride; }
+    std::size_t transformBytes() const { return (format == TransformFormat::Matrix ? 16 : 7) * sizeof(float); }
+
+    ///entities deleted between the last two extract calls; may include some never extracted (created and
+    /// deleted in between). Valid until the next extract call
+    const std::vector<EntityID>& removed() const { return removedList; }
+
+    void moduleCreated(SystemBase& sys, EntityID eID) { fieldChanged(sys, eID); }
+    void moduleModified(SystemBase& sys, EntityID eID) { fieldChanged(sys, eID); }
+    void moduleDestroyed(SystemBase& sys, EntityID eID) { fieldChanged(sys, eID); }
+
+    MemoryReport memoryReport() const {
+        MemoryReport out("Extractor");
+        out.add("fields", vectorBytes(fields) + vectorBytes(fieldTypes));
+        out.add("pending", vectorBytes(created) + vectorBytes(dirty) + vectorBytes(settled) + vectorBytes(pending));
+        out.add("moving", vectorBytes(moving) + vectorBytes(scratchMoving));
+        out.add("removed", vectorBytes(erased) + vectorBytes(removedList));
+        return out;
+    }
+
+    private:
+    friend class WorldBase;
+
+    TransformFormat format;
+    std::size_t stride;
+    std::size_t transformOffset;
+    bool attached;
+
+    std::vector<std::function<void(Entity&, char*)>> fields;
+    std::vector<SystemType> fieldTypes;
+
+    ///filled by WorldBase and the field Systems between extract calls
+    std::vector<EntityID> created;
+    std::vector<EntityID> dirty;
+    std::vector<EntityID> settled;
+    std::vector<EntityID> erased;
+    ///entities that were moving at the last extract call, so their last record was mid-interpolation
+    std::vector<EntityID> moving;
+
+    std::vector<EntityID> scratchMoving;
+    std::vector<EntityID> pending;
+    std::vector<EntityID> removedList;
+
+    void checkFits(std::size_t offset, std::size_t size, const char* what) const {
+        if (offset + size > stride) {
+            throw std::invalid_argument(std::string("Extractor ") + what + " at byte " + std::to_string(offset) + " doesn't fit a "
+                                        + std::to_string(stride) + " byte record");
+        }
+    }
+
+    void fieldChanged(SystemBase& sys, EntityID eID) {
+        if (std::find(fieldTypes.begin(), fieldTypes.end(), sys.getType()) != fieldTypes.end()) dirty.push_back(eID);
+    }
+
+    static bool isMoving(const Entity& e) {
+        Placement prev = e.getPrevPos();
+        return std::memcmp(&prev, &e.pos, sizeof(Placement)) != 0;
+    }
+
+    ///returns whether e is moving (so the record is interpolated)
+    bool write(Entity& e, char* record, double alpha) const {
+        bool moving = isMoving(e);
+        Placement p = moving ? Placement::interpolate(e.getPrevPos(), e.pos, alpha) : e.pos;
+
+        float t[16];
+        if (format == TransformFormat::Matrix) {
+            p.toMatrix(t);
+        }
+        else {
+            t[0] = float(p.pos.x); t[1] = float(p.pos.y); t[2] = float(p.pos.z);
+            p.dir.toFloats(t + 3);
+        }
+        std::memcpy(record + transformOffset, t, transformBytes());
+
+        for (auto& f : fields) f(e, record);
+        return moving;
+    }
+};
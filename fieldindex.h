@@ -0,0 +1,217 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <cstddef>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+#include "component.h"
+
+///secondary index over a key projected from a single-module System's Instances: a binary min-heap (plus each
+/// entity's heap position), kept current through the System's observers. Creation, touch()/modify() and destruction
+/// move one entry in O(log n), usually fewer steps when keys drift a little per frame (timers, health)
+///queries cost O(k log k) for k results instead of a pass over every module, ex (as a System member; name the
+/// SimpleSystem base there, since the System itself is still incomplete):
+///  FieldIndex<SimpleSystem<HealthValue, SystemType::Health>, double> byHealth{*this, [] (const HealthValue& h) { return h.curHealth; }};
+///  byHealth.forEachUpTo(0., [&] (EntityID eID, double hp) { ... });
+///writes that change the key without touch()/modify() leave the module under its old key until it's next touched
+template <class Sys, class Key, class Compare = std::less<Key>>
+class FieldIndex : public ModuleObserver {
+    static_assert(Sys::SingleModule, "FieldIndex needs a System with one Instance per entity");
+
+    public:
+    typedef typename Sys::InstanceType Instance;
+
+    ///indexes the modules sys already has
+    FieldIndex(Sys& s, std::function<Key(const Instance&)> projection)
+        : sys(s), project(std::move(projection)) {
+        sys.addObserver(this);
+        sys.applyFunctionToAllModules([this] (EntityID eID, Entity&, Instance&) { reindex(eID); });
+    }
+
+    ~FieldIndex() {
+        sys.removeObserver(this);
+    }
+
+    FieldIndex(const FieldIndex&) = delete;
+    FieldIndex& operator= (const FieldIndex&) = delete;
+
+    void moduleCreated(SystemBase& s, EntityID eID) { reindex(eID); }
+    void moduleModified(SystemBase& s, EntityID eID) { reindex(eID); }
+    void moduleDestroyed(SystemBase& s, EntityID eID) { erase(eID); }
+
+    ///re-reads eID's key; for modules written without touch()
+    void reindex(EntityID eID) {
+        const Instance* m = static_cast<const Instance*>(sys.Sys::modulePtr(eID));
+        if (m == nullptr) {
+            erase(eID);
+            return;
+        }
+
+        auto it = position.find(eID);
+        if (it == position.end()) {
+            heap.push_back(Entry(project(*m), eID));
+            position.emplace(eID, heap.size() - 1);
+            siftUp(heap.size() - 1);
+            return;
+        }
+
+        std::size_t i = it->second;
+        heap[i].first = project(*m);
+        if (!siftUp(i)) siftDown(i);
+    }
+
+    ///f(EntityID, const Key&) for every module with key <= threshold, smallest first
+    ///the matches are gathered before f runs, so f may touch, remove or delete entities freely
+    template <class F>
+    void forEachUpTo(const Key& threshold, F f) {
+        visiting.clear();
+
+        //every ancestor of a match is a match, so this only walks the matches and their children
+        if (!heap.empty()) stack.push_back(0);
+        while (!stack.empty()) {
+            std::size_t i = stack.back();
+            stack.pop_back();
+            if (Compare()(threshold, heap[i].first)) continue;
+
+            visiting.push_back(heap[i]);
+            if (2*i + 1 < heap.size()) stack.push_back(2*i + 1);
+            if (2*i + 2 < heap.size()) stack.push_back(2*i + 2);
+        }
+
+        std::sort(visiting.begin(), visiting.end(), less);
+        for (auto& e : visiting) f(e.second, e.first);
+    }
+
+    ///f(EntityID, const Key&) for the n smallest keys, smallest first (ex: the next n timers to expire);
+    /// same rules for f as forEachUpTo
+    template <class F>
+    void forEachFirst(std::size_t n, F f) {
+        visiting.clear();
+
+        //best-first walk down the heap: the next smallest is always a child of one already taken
+        auto greater = [this] (std::size_t a, std::size_t b) { return less(heap[b], heap[a]); };
+        auto push = [&] (std::size_t i) {
+            stack.push_back(i);
+            std::push_heap(stack.begin(), stack.end(), greater);
+        };
+
+        stack.clear();
+        if (!heap.empty()) push(0);
+
+        while (!stack.empty() && visiting.size() < n) {
+            std::pop_heap(stack.begin(), stack.end(), greater);
+            std::size_t i = stack.back();
+            stack.pop_back();
+
+            visiting.push_back(heap[i]);
+            if (2*i + 1 < heap.size()) push(2*i + 1);
+            if (2*i + 2 < heap.size()) push(2*i + 2);
+        }
+        stack.clear();
+
+        for (auto& e : visiting) f(e.second, e.first);
+    }
+
+    ///appends the EIDs of every module with key <= threshold to out, smallest key first
+    void collectUpTo(const Key& threshold, std::vector<EntityID>& out) {
+        forEachUpTo(threshold, [&] (EntityID eID, const Key& k) { out.push_back(eID); });
+    }
+
+    ///nullptr if eID isn't indexed
+    const Key* keyOf(EntityID eID) const {
+        auto it = position.find(eID);
+        return it == position.end() ? nullptr : &heap[it->second].first;
+    }
+
+    ///the smallest indexed key's entry; check empty() first
+    const std::pair<Key, EntityID>& front() const { return heap.front(); }
+
+    std::size_t size() const { return heap.size(); }
+    bool empty() const { return heap.empty(); }
+
+    MemoryReport memoryReport() const {
+        MemoryReport out(std::string("FieldIndex ") + std::to_string(sys.getType()));
+        out.add("heap", vectorBytes(heap));
+        out.add("position", hashContainerBytes(position));
+        out.add("scratch", vectorBytes(visiting) + vectorBytes(stack));
+        return out;
+    }
+
+    private:
+    typedef std::pair<Key, EntityID> Entry;
+
+    Sys& sys;
+    std::function<Key(const Instance&)> project;
+
+    std::vector<Entry> heap;
+    std::unordered_map<EntityID, std::size_t> position;
+
+    std::vector<Entry> visiting;
+    ///forEachUpTo's walk stack, and forEachFirst's frontier heap
+    std::vector<std::size_t> stack;
+
+    ///ties in EID order, so query results don't depend on insertion order
+    static bool less(const Entry& a, const Entry& b) {
+        if (Compare()(a.first, b.first)) return true;
+        if (Compare()(b.first, a.first)) return false;
+        return a.second < b.second;
+    }
+
+    void place(std::size_t i, Entry&& e) {
+        heap[i] = std::move(e);
+        position[heap[i].second] = i;
+    }
+
+    ///returns whether the entry moved
+    bool siftUp(std::size_t i) {
+        if (i == 0 || !less(heap[i], heap[(i - 1) / 2])) return false;
+
+        Entry e = std::move(heap[i]);
+        while (i > 0 && less(e, heap[(i - 1) / 2])) {
+            std::size_t parent = (i - 1) / 2;
+            place(i, std::move(heap[parent]));
+            i = parent;
+        }
+        place(i, std::move(e));
+        return true;
+    }
+
+    void siftDown(std::size_t i) {
+        Entry e = std::move(heap[i]);
+        std::size_t start = i;
+
+        while (true) {
+            std::size_t child = 2*i + 1;
+            if (child >= heap.size()) break;
+            if (child + 1 < heap.size() && less(heap[child + 1], heap[child])) child++;
+            if (!less(heap[child], e)) break;
+
+            place(i, std::move(heap[child]));
+            i = child;
+        }
+
+        if (i == start) heap[i] = std::move(e);
+        else place(i, std::move(e));
+    }
+
+    void erase(EntityID eID) {
+        auto it = position.find(eID);
+        if (it == position.end()) return;
+
+        std::size_t i = it->second;
+        position.erase(it);
+
+        if (i + 1 == heap.size()) {
+            heap.pop_back();
+            return;
+        }
+
+        place(i, std::move(heap.back()));
+        heap.pop_back();
+        if (!siftUp(i)) siftDown(i);
+    }
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+#include <shared_mutex>
+#include <unordered_map>
+#include <type_traits>
+
+#include "component.h"
+
+///lets WorldBase publish every FrontBuffer at the end of a frame without knowing their Systems
+class IFrontBuffer {
+    public:
+    virtual ~IFrontBuffer() {}
+
+    ///copies modules changed since the last publish into the front buffer; update thread only
+    virtual void publish(std::uint64_t frame) =0;
+    virtual MemoryReport memoryReport() const =0;
+};
+
+///opt-in double buffering of one System's modules, made and owned by WorldBase::doubleBuffer, ex:
+///  FrontBuffer<PhysicsSystem>& physicsFront = world.doubleBuffer(world.physics);
+///  //any thread, any time; the view is frame N's state while the update thread simulates N+1
+///  auto view = physicsFront.read();
+///  if (const Body* b = view.get(target)) ...
+///the System's own storage is the back buffer, written as usual; at the end of each frame the modules created,
+/// touch()ed or destroyed during it are copied to the front buffer, so a frame costs only what changed
+///writes made without touch()/modify() aren't seen until the module is next touched
+///
+///publishing waits for readers to release their views, so a view held across a whole frame (ex: a render thread
+/// reading frame N while N+1 simulates) delays endFrame until it's released; hold views for at most a frame
+template <class Sys>
+class FrontBuffer : public IFrontBuffer, public ModuleObserver {
+    public:
+    typedef typename Sys::TemplateType Template;
+    typedef typename Sys::InstanceType Instance;
+    ///a single Instance per entity for Systems, all of an entity's Instances for MultiSystems
+    typedef typename std::conditional<Sys::SingleModule, Instance, std::vector<Instance>>::type Slot;
+
+    static_assert(std::is_copy_constructible<Instance>::value, "FrontBuffer copies Instances, so they need a copy constructor");
+
+    ///a consistent, read-only view of the front buffer; publishing waits until every View is gone
+    class View {
+        const FrontBuffer* buffer;
+        std::shared_lock<std::shared_mutex> lock;
+
+        public:
+        View(const FrontBuffer& b)
+            : buffer(&b), lock(b.mutex) {}
+
+        ///nullptr if eid had no module at the end of the published frame
+        const Instance* get(EntityID eid) const requires Sys::SingleModule {
+            auto it = buffer->front.find(eid);
+            return it == buffer->front.end() ? nullptr : &it->second;
+        }
+
+        ///eid's Instances as of the published frame (empty if none)
+        const std::vector<Instance>& modules(EntityID eid) const requires (!Sys::SingleModule) {
+            static const std::vector<Instance> none;
+            auto it = buffer->front.find(eid);
+            return it == buffer->front.end() ? none : it->second;
+        }
+
+        bool has(EntityID eid) const { return buffer->front.count(eid) > 0; }
+        std::size_t size() const { return buffer->front.size(); }
+
+        ///f(EntityID, const Instance&) for every published module, in no particular order
+        template <class F>
+        void forEach(F f) const {
+            for (auto& e : buffer->front) {
+                if constexpr (Sys::SingleModule) f(e.first, e.second);
+                else for (auto& i : e.second) f(e.first, i);
+            }
+        }
+
+        ///the World frame this view shows (counts endFrame calls)
+        std::uint64_t frame() const { return buffer->publishedFrame; }
+    };
+
+    FrontBuffer(Sys& s)
+        : sys(s), publishedFrame(0) {
+        sys.addObserver(this);
+
+        //start from everything already in the System
+        std::unique_ptr<IModuleColumn> column = sys.snapshotModules(nullptr);
+        apply(column.get(), {});
+    }
+
+    FrontBuffer(const FrontBuffer&) = delete;
+    FrontBuffer& operator= (const FrontBuffer&) = delete;
+
+    View read() const { return View(*this); }
+
+    void moduleCreated(SystemBase& s, EntityID eID) { dirty.push_back(eID); }
+    void moduleModified(SystemBase& s, EntityID eID) { dirty.push_back(eID); }
+    void moduleDestroyed(SystemBase& s, EntityID eID) { dirty.push_back(eID); }
+
+    void publish(std::uint64_t frame) {
+        std::sort(dirty.begin(), dirty.end());
+        dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+
+        //the copies are made before taking the lock, so readers only wait for the front buffer's update
+        std::unique_ptr<IModuleColumn> column;
+        if (!dirty.empty()) column = sys.snapshotModules(&dirty);
+
+        apply(column.get(), dirty, frame);
+        dirty.clear();
+    }
+
+    MemoryReport memoryReport() const {
+        MemoryReport out(std::string("FrontBuffer ") + std::to_string(sys.getType()));
+
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        std::size_t instances = 0;
+        if constexpr (Sys::SingleModule) instances = front.size() * sizeof(Instance);
+        else for (auto& e : front) instances += vectorBytes(e.second);
+
+        out.add("front", hashContainerBytes(front));
+        out.add("instances", instances);
+        out.add("dirty", vectorBytes(dirty));
+        return out;
+    }
+
+    private:
+    Sys& sys;
+    std::unordered_map<EntityID, Slot> front;
+    std::uint64_t publishedFrame;
+    mutable std::shared_mutex mutex;
+
+    std::vector<EntityID> dirty;
+
+    ///replaces changed's front entries with the column's modules
+    void apply(IModuleColumn* column, const std::vector<EntityID>& changed, std::uint64_t frame = 0) {
+        auto* typed = dynamic_cast<ModuleColumn<Template, Instance>*>(column);
+        assert((column == nullptr || typed != nullptr) && "FrontBuffer needs a System that snapshots to a ModuleColumn");
+
+        std::unique_lock<std::shared_mutex> lock(mutex);
+
+        for (EntityID eid : changed) front.erase(eid);
+
+        if (typed != nullptr) {
+            for (std::size_t i = 0; i < typed->size(); i++) {
+                if constexpr (Sys::SingleModule) front.insert_or_assign(typed->eids[i], std::move(typed->instances[i]));
+                else front[typed->eids[i]].push_back(std::move(typed->instances[i]));
+            }
+        }
+
+        publishedFrame = frame;
+    }
+};
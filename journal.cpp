@@ -0,0 +1,282 @@
+#include "journal.h"
+#include "worldbase.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
+static_assert(std::is_trivially_copyable<Placement>::value, "Journal writes Placements as raw bytes");
+
+namespace {
+    const std::uint32_t blockMagic = 0x4C4E524A;
+
+    struct BlockHeader {
+        std::uint32_t magic;
+        std::uint32_t checksum;
+        std::uint64_t generation;
+        std::uint64_t size;
+    };
+
+    ///FNV-1a; only needs to catch torn/garbage writes
+    std::uint32_t checksum(const char* data, std::size_t size) {
+        std::uint32_t h = 2166136261u;
+        for (std::size_t i = 0; i < size; i++) {
+            h ^= (unsigned char) data[i];
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    struct Block {
+        std::uint64_t generation;
+        std::vector<char> payload;
+    };
+
+    ///reads complete, valid blocks until the first bad one; validBytes is where that one starts
+    std::vector<Block> readBlocks(const std::string& filename, std::size_t& validBytes) {
+        std::vector<Block> out;
+        validBytes = 0;
+
+        std::FILE* f = std::fopen(filename.c_str(), "rb");
+        if (f == nullptr) return out;
+
+        while (true) {
+            BlockHeader h;
+            if (std::fread(&h, sizeof(h), 1, f) != 1 || h.magic != blockMagic) break;
+
+            Block b;
+            b.generation = h.generation;
+            b.payload.resize(h.size);
+            if (h.size && std::fread(b.payload.data(), h.size, 1, f) != 1) break;
+            if (checksum(b.payload.data(), b.payload.size()) != h.checksum) break;
+
+            validBytes += sizeof(h) + h.size;
+            out.push_back(std::move(b));
+        }
+
+        std::fclose(f);
+        return out;
+    }
+}
+
+
+Journal::Journal(const std::string& _path, bool syncToDisk)
+    : path(_path), sync(syncToDisk), file(nullptr), generation(0) {
+    std::size_t unused;
+    std::vector<Block> cp = readBlocks(path + ".checkpoint", unused);
+    if (!cp.empty()) generation = cp.front().generation;
+
+    open();
+}
+
+Journal::~Journal() {
+    if (file) std::fclose(file);
+}
+
+void Journal::open() {
+    if (file) std::fclose(file);
+
+    //cut the journal back to its last complete frame of this generation, so new frames aren't stranded
+    // behind a torn one
+    std::string name = path + ".journal";
+    std::size_t validBytes = 0;
+    std::vector<Block> blocks = readBlocks(name, validBytes);
+    for (auto& b : blocks) if (b.generation != generation) validBytes = 0;
+
+    std::error_code ec;
+    if (std::filesystem::exists(name, ec)) std::filesystem::resize_file(name, validBytes, ec);
+
+    file = std::fopen(name.c_str(), "ab");
+    if (file == nullptr) throw std::runtime_error("Journal couldn't open " + name);
+}
+
+void Journal::writeBlock(std::FILE* f, const std::vector<char>& payload) {
+    BlockHeader h{blockMagic, checksum(payload.data(), payload.size()), generation, payload.size()};
+
+    std::fwrite(&h, sizeof(h), 1, f);
+    if (!payload.empty()) std::fwrite(payload.data(), payload.size(), 1, f);
+    std::fflush(f);
+
+#ifdef __unix__
+    if (sync) fsync(fileno(f));
+#endif
+}
+
+void Journal::encodeHeader(std::vector<char>& out, RecordKind kind, EntityID eID) {
+    encodePOD<std::uint8_t>(kind, out);
+    encodePOD<std::int64_t>(eID.ID, out);
+}
+
+///kind, eID, SystemType, size, then the System's own encoding
+bool Journal::encodeModules(std::vector<char>& out, EntityID eID, SystemBase& sys) {
+    std::size_t start = out.size();
+
+    encodeHeader(out, Modules, eID);
+    encodePOD<std::int32_t>(sys.getType(), out);
+
+    std::size_t sizeAt = out.size();
+    encodePOD<std::uint64_t>(0, out);
+
+    if (!sys.encodeModules(eID, out)) {
+        out.resize(start);
+        return false;
+    }
+
+    std::uint64_t size = out.size() - sizeAt - sizeof(std::uint64_t);
+    std::memcpy(out.data() + sizeAt, &size, sizeof(size));
+    return true;
+}
+
+void Journal::entityCreated(EntityID eID, const Placement& p) {
+    encodeHeader(frame, EntityCreated, eID);
+    encodePOD(p, frame);
+}
+
+void Journal::entityDeleted(EntityID eID) {
+    encodeHeader(frame, EntityDeleted, eID);
+}
+
+void Journal::entityMoved(EntityID eID, const Placement& p) {
+    encodeHeader(frame, EntityMoved, eID);
+    encodePOD(p, frame);
+}
+
+void Journal::moduleRemoved(EntityID eID, SystemType st) {
+    encodeHeader(frame, ModulesRemoved, eID);
+    encodePOD<std::int32_t>(st, frame);
+}
+
+void Journal::commitFrame() {
+    //modules are encoded once, as they are at the end of the frame; ones removed since are skipped
+    std::sort(dirty.begin(), dirty.end(), [] (const std::pair<EntityID, SystemBase*>& a, const std::pair<EntityID, SystemBase*>& b) {
+        return a.first < b.first || (a.first == b.first && a.second < b.second);
+    });
+    dirty.erase(std::unique(dirty.begin(), dirty.end(), [] (const std::pair<EntityID, SystemBase*>& a, const std::pair<EntityID, SystemBase*>& b) {
+        return a.first == b.first && a.second == b.second;
+    }), dirty.end());
+
+    for (auto& d : dirty) encodeModules(frame, d.first, *d.second);
+    dirty.clear();
+
+    if (frame.empty()) return;
+
+    writeBlock(file, frame);
+    frame.clear();
+}
+
+void Journal::checkpoint(WorldBase& world) {
+    std::vector<char> state;
+
+    for (auto& e : world.entities) {
+        encodeHeader(state, EntityCreated, e.first);
+        encodePOD(e.second->pos, state);
+    }
+    for (auto& e : world.entities) {
+        for (SystemBase* sys : e.second->getRelatedSystems()) {
+            if (sys->canEncodeModules()) encodeModules(state, e.first, *sys);
+        }
+    }
+
+    //everything pending is in the checkpoint
+    frame.clear();
+    dirty.clear();
+
+    generation++;
+
+    std::string name = path + ".checkpoint";
+    std::string tmp = name + ".tmp";
+
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (f == nullptr) throw std::runtime_error("Journal couldn't open " + tmp);
+    writeBlock(f, state);
+#ifdef __unix__
+    fsync(fileno(f));
+#endif
+    std::fclose(f);
+
+    std::filesystem::rename(tmp, name);
+
+    //the old journal's blocks now have a stale generation, so open() empties it
+    open();
+}
+
+void Journal::replay(const std::vector<char>& payload, WorldBase& world,
+                     std::vector<std::pair<EntityID, SystemBase*>>& created) {
+    const char* data = payload.data();
+    std::size_t offset = 0;
+
+    while (offset < payload.size()) {
+        RecordKind kind = (RecordKind) decodePOD<std::uint8_t>(data, offset);
+        EntityID eID = decodePOD<std::int64_t>(data, offset);
+
+        switch (kind) {
+            case EntityCreated: {
+                Placement p = decodePOD<Placement>(data, offset);
+                world.insertEntity(std::make_unique<Entity>(eID, p), false);
+                world.ids.claim(eID);
+                break;
+            }
+            case EntityDeleted:
+                world.eraseEntity(eID);
+                break;
+            case EntityMoved:
+                world.getEntity(eID).pos = decodePOD<Placement>(data, offset);
+                break;
+            case Modules: {
+                SystemBase& sys = world.systemForCreation((SystemType) decodePOD<std::int32_t>(data, offset));
+                std::uint64_t size = decodePOD<std::uint64_t>(data, offset);
+
+                if (!sys.decodeModules(eID, data + offset, size)) {
+                    throw std::runtime_error("Journal has modules for SystemType " + std::to_string(sys.getType()) + ", which can't decode them");
+                }
+                offset += size;
+
+                if (world.getEntity(eID).addRelatedSystem(&sys)) created.push_back(std::make_pair(eID, &sys));
+                break;
+            }
+            case ModulesRemoved: {
+                SystemBase& sys = world.systemForRemoval((SystemType) decodePOD<std::int32_t>(data, offset));
+                if (sys.removeModule(eID)) world.getEntity(eID).removeRelatedSystem(&sys);
+                break;
+            }
+            default:
+                throw std::runtime_error("Journal has an unknown record kind");
+        }
+    }
+}
+
+std::size_t Journal::recover(const std::string& path, WorldBase& world) {
+    if (world.journal != nullptr) throw std::invalid_argument("Journal::recover needs a world without a journal set");
+
+    std::size_t validBytes;
+    std::vector<Block> cp = readBlocks(path + ".checkpoint", validBytes);
+    std::uint64_t generation = cp.empty() ? 0 : cp.front().generation;
+
+    if (cp.empty() && std::filesystem::exists(path + ".checkpoint")) {
+        throw std::runtime_error("Journal checkpoint " + path + ".checkpoint is corrupt");
+    }
+
+    std::vector<std::pair<EntityID, SystemBase*>> created;
+    if (!cp.empty()) replay(cp.front().payload, world, created);
+
+    std::size_t frames = 0;
+    for (auto& b : readBlocks(path + ".journal", validBytes)) {
+        if (b.generation != generation) break;
+
+        replay(b.payload, world, created);
+        frames++;
+    }
+
+    //postCreate once everything's in, like loadSnapshot
+    std::sort(created.begin(), created.end());
+    created.erase(std::unique(created.begin(), created.end()), created.end());
+    for (auto& c : created) {
+        if (world.hasEntity(c.first) && c.second->hasModules(c.first)) c.second->postCreate(c.first);
+    }
+
+    return frames;
+}
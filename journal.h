@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+
+#include "component.h"
+#include "3dmath.h"
+
+class WorldBase;
+
+///write-ahead journal of World changes, for recovery without frequent full saves, ex:
+///  Journal journal("saves/world");
+///  Journal::recover("saves/world", world);   //last checkpoint + every complete frame after it
+///  world.setJournal(&journal);
+///  ...world.update(dt)...                    //each update appends one frame block
+///  journal.checkpoint(world);                //every few minutes; restarts the journal
+///
+///records are binary: entity creation/deletion, component removal, moved Placements, and the full contents of
+/// every module created or touch()ed during the frame (once per module per frame)
+///they're buffered during the frame and appended as one checksummed block at the end of WorldBase::update,
+/// so recovery stops at the last complete frame
+///
+///every System in the World needs Instances with a JournalCodec (trivially copyable ones work as is);
+/// Tasks aren't journaled, and Placements written between updates are only journaled with the next move
+/// during a frame (call entityMoved for those)
+///
+///files: <path>.checkpoint and <path>.journal
+class Journal : public ModuleObserver {
+    public:
+    ///opens (or creates) the journal, dropping any torn frame at its end
+    Journal(const std::string& path, bool syncToDisk = false);
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator= (const Journal&) = delete;
+
+    ///loads <path>.checkpoint then replays <path>.journal into world, which should be empty and have no journal set
+    /// returns the number of frames replayed; throws std::runtime_error on a corrupt checkpoint
+    static std::size_t recover(const std::string& path, WorldBase& world);
+
+    ///writes world's full state as the new checkpoint, then empties the journal
+    /// the checkpoint is written to a temp file and renamed, so a crash mid-checkpoint keeps the old one
+    void checkpoint(WorldBase& world);
+
+    ///called by WorldBase
+    void entityCreated(EntityID eID, const Placement& p);
+    void entityDeleted(EntityID eID);
+    void entityMoved(EntityID eID, const Placement& p);
+    void moduleRemoved(EntityID eID, SystemType st);
+    ///group commit: encodes this frame's touched modules, then appends the frame's records in one write
+    void commitFrame();
+
+    void moduleCreated(SystemBase& sys, EntityID eID) { dirty.push_back(std::make_pair(eID, &sys)); }
+    void moduleModified(SystemBase& sys, EntityID eID) { dirty.push_back(std::make_pair(eID, &sys)); }
+
+    std::size_t pendingBytes() const { return frame.size(); }
+    std::uint64_t getGeneration() const { return generation; }
+
+    private:
+    enum RecordKind : std::uint8_t {
+        EntityCreated,
+        EntityDeleted,
+        EntityMoved,
+        Modules,
+        ModulesRemoved
+    };
+
+    std::string path;
+    bool sync;
+    std::FILE* file;
+    ///bumped by every checkpoint; journal blocks from another generation are stale
+    std::uint64_t generation;
+
+    std::vector<char> frame;
+    std::vector<std::pair<EntityID, SystemBase*>> dirty;
+
+    void open();
+    void writeBlock(std::FILE* f, const std::vector<char>& payload);
+
+    static void encodeHeader(std::vector<char>& out, RecordKind kind, EntityID eID);
+    static bool encodeModules(std::vector<char>& out, EntityID eID, SystemBase& sys);
+    static void replay(const std::vector<char>& payload, WorldBase& world,
+                       std::vector<std::pair<EntityID, SystemBase*>>& created);
+};
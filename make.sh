@@ -1,2 +1,6 @@
 #!/bin/bash
-g++ vec2.cpp 3dmath.cpp component.cpp worldbase.cpp actor.cpp example.cpp -o exampleProgram
\ No newline at end of file
+g++ -std=c++20 memory.cpp vec2.cpp 3dmath.cpp component.cpp worldbase.cpp actor.cpp task.cpp snapshot.cpp journal.cpp statehash.cpp broadphase.cpp navgrid.cpp navsystem.cpp examplegame.cpp example.cpp -pthread -o exampleProgram
+g++ -std=c++20 -O2 memory.cpp vec2.cpp 3dmath.cpp component.cpp worldbase.cpp actor.cpp task.cpp snapshot.cpp journal.cpp statehash.cpp broadphase.cpp navgrid.cpp navsystem.cpp examplegame.cpp soak.cpp -pthread -o soakTest
+g++ -std=c++20 -O2 memory.cpp vec2.cpp 3dmath.cpp component.cpp worldbase.cpp actor.cpp task.cpp snapshot.cpp journal.cpp statehash.cpp broadphase.cpp navgrid.cpp navsystem.cpp examplegame.cpp podbench.cpp -pthread -o podBenchmark
+g++ -std=c++20 -O2 -DWEDGE_COUNT_ALLOCATIONS memory.cpp vec2.cpp 3dmath.cpp component.cpp worldbase.cpp actor.cpp task.cpp snapshot.cpp journal.cpp statehash.cpp broadphase.cpp navgrid.cpp navsystem.cpp examplegame.cpp alloctest.cpp -pthread -o allocTest
+g++ -std=c++20 memory.cpp vec2.cpp 3dmath.cpp component.cpp worldbase.cpp actor.cpp task.cpp snapshot.cpp journal.cpp statehash.cpp broadphase.cpp navgrid.cpp navsystem.cpp examplegame.cpp tests.cpp -pthread -o testProgram
\ No newline at end of file
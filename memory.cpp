@@ -0,0 +1,45 @@
+#include "memory.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace {
+    thread_local std::size_t allocCount = 0;
+    thread_local std::size_t allocBytes = 0;
+}
+
+AllocationStats AllocationCounter::current() {
+    return AllocationStats(allocCount, allocBytes);
+}
+
+void releaseFreeMemory() {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+#ifdef WEDGE_COUNT_ALLOCATIONS
+
+void* operator new(std::size_t n) {
+    allocCount++;
+    allocBytes += n;
+
+    void* out = std::malloc(n ? n : 1);
+    if (out == nullptr) throw std::bad_alloc();
+    return out;
+}
+
+void* operator new[](std::size_t n) {
+    return operator new(n);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+#endif
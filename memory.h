@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <iostream>
+
+///bookkeeping for how much memory Systems/Worlds hold, and how many heap allocations a frame causes
+/// byte counts are estimates; hash container sizes assume the libstdc++ node layout (next ptr + cached hash + value)
+
+struct MemoryReport {
+    std::string name;
+    std::vector<std::pair<std::string, std::size_t>> containers;
+    std::vector<MemoryReport> children;
+
+    MemoryReport(std::string n)
+        : name(n) {}
+
+    void add(const std::string& container, std::size_t bytes) {
+        containers.push_back(std::make_pair(container, bytes));
+    }
+
+    ///includes children
+    std::size_t total() const {
+        std::size_t out = 0;
+        for (auto& c : containers) out += c.second;
+        for (auto& c : children) out += c.total();
+        return out;
+    }
+
+    friend std::ostream& operator<<(std::ostream& o, const MemoryReport& r) {
+        r.print(o, 0);
+        return o;
+    }
+
+    private:
+    void print(std::ostream& o, int depth) const {
+        std::string indent(depth*2, ' ');
+        o<<indent<<name<<": "<<total()<<"B\n";
+        for (auto& c : containers) o<<indent<<"  "<<c.first<<": "<<c.second<<"B\n";
+        for (auto& c : children) c.print(o, depth+1);
+    }
+};
+
+template <class Map>
+std::size_t hashContainerBytes(const Map& m) {
+    std::size_t node = sizeof(void*) + sizeof(std::size_t) + sizeof(typename Map::value_type);
+    return m.bucket_count()*sizeof(void*) + m.size()*node;
+}
+
+template <class T>
+std::size_t vectorBytes(const std::vector<T>& v) {
+    return v.capacity()*sizeof(T);
+}
+
+///rehashes m down if its bucket array is far bigger than its contents need (ex: after a load spike)
+/// O(size) when it does; returns whether it did
+template <class Map>
+bool shrinkHashContainer(Map& m) {
+    std::size_t needed = (std::size_t) (m.size() / m.max_load_factor()) + 1;
+    if (m.bucket_count() <= 4*needed || m.bucket_count() <= 16) return false;
+
+    m.rehash(0);
+    return true;
+}
+
+template <class T>
+bool shrinkVector(std::vector<T>& v) {
+    if (v.capacity() <= 4*v.size() || v.capacity()*sizeof(T) <= 4096) return false;
+
+    v.shrink_to_fit();
+    return true;
+}
+
+///hands freed heap pages back to the OS, where the allocator supports it (glibc)
+void releaseFreeMemory();
+
+///extra bytes a shared_ptr allocation carries next to its object (two refcounts + vtable)
+constexpr std::size_t sharedControlBlockBytes() {
+    return 2*sizeof(int) + sizeof(void*);
+}
+
+
+struct AllocationStats {
+    std::size_t allocations;
+    std::size_t bytes;
+
+    AllocationStats()
+        : allocations(0), bytes(0) {}
+    AllocationStats(std::size_t a, std::size_t b)
+        : allocations(a), bytes(b) {}
+
+    AllocationStats operator-(const AllocationStats& o) const {
+        return AllocationStats(allocations - o.allocations, bytes - o.bytes);
+    }
+    AllocationStats operator+(const AllocationStats& o) const {
+        return AllocationStats(allocations + o.allocations, bytes + o.bytes);
+    }
+
+    friend std::ostream& operator<<(std::ostream& o, const AllocationStats& a) {
+        return o<<a.allocations<<" allocs/"<<a.bytes<<"B";
+    }
+};
+
+///global operator new is only replaced when compiled with -DWEDGE_COUNT_ALLOCATIONS;
+/// otherwise these counters stay at 0, so the hook costs nothing in normal builds
+namespace AllocationCounter {
+    constexpr bool enabled() {
+#ifdef WEDGE_COUNT_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    ///totals for the calling thread since program start
+    AllocationStats current();
+}
@@ -0,0 +1,208 @@
+#include "navgrid.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+NavGrid::NavGrid(int width, int height, std::uint8_t cost)
+    : w(width), h(height), changes(0) {
+    if (width <= 0 || height <= 0) {
+        throw std::invalid_argument("NavGrid needs a positive size, got " + std::to_string(width) + "x" + std::to_string(height));
+    }
+    costs.assign(std::size_t(width) * height, cost);
+}
+
+void NavGrid::setCost(Coord c, std::uint8_t cost) {
+    if (!contains(c)) {
+        throw std::out_of_range("NavGrid::setCost: (" + std::to_string(c.x) + ", " + std::to_string(c.y) + ") is off the grid");
+    }
+    costs[index(c)] = cost;
+    changes++;
+}
+
+Coord NavGrid::direction(int d) {
+    static const Coord dirs[8] = {Coord(-1, -1), Coord(0, -1), Coord(1, -1),
+                                  Coord(-1,  0),               Coord(1,  0),
+                                  Coord(-1,  1), Coord(0,  1), Coord(1,  1)};
+    return dirs[d];
+}
+
+std::uint32_t NavGrid::estimate(std::uint32_t a, std::uint32_t b) const {
+    std::uint32_t dx = std::abs(int(a % w) - int(b % w));
+    std::uint32_t dy = std::abs(int(a / w) - int(b / w));
+    return StraightLength * std::max(dx, dy) + (DiagonalLength - StraightLength) * std::min(dx, dy);
+}
+
+MemoryReport NavGrid::memoryReport() const {
+    MemoryReport out("NavGrid");
+    out.add("costs", vectorBytes(costs));
+    return out;
+}
+
+
+FlowField::FlowField()
+    : target(), w(0), h(0), builtFrom(0) {}
+
+Coord FlowField::next(Coord c) const {
+    if (!contains(c)) return c;
+
+    std::int8_t d = dir[index(c)];
+    if (d < 0) return c;
+
+    Coord step = NavGrid::direction(d);
+    return Coord(c.x + step.x, c.y + step.y);
+}
+
+
+//a key grows by at most two moves' cost per expansion (the move, plus the estimate shrinking by at most as much)
+static const std::size_t BucketCount = 8192;
+static const std::uint32_t None = std::numeric_limits<std::uint32_t>::max();
+static_assert(BucketCount > 2 * NavGrid::DiagonalLength * 255, "a push can land past the whole ring");
+
+GridPathfinder::BucketQueue::BucketQueue()
+    : heads(BucketCount, None), cursor(0), count(0) {}
+
+void GridPathfinder::BucketQueue::reset(std::uint32_t startKey) {
+    if (count > 0) std::fill(heads.begin(), heads.end(), None);
+    entries.clear();
+    cursor = startKey;
+    count = 0;
+}
+
+void GridPathfinder::BucketQueue::push(std::uint32_t key, std::uint32_t cell) {
+    assert(key >= cursor && key - cursor < BucketCount);
+    std::uint32_t& head = heads[key % BucketCount];
+    entries.push_back(Entry{cell, head});
+    head = std::uint32_t(entries.size() - 1);
+    count++;
+}
+
+std::uint32_t GridPathfinder::BucketQueue::pop() {
+    assert(count > 0);
+    while (heads[cursor % BucketCount] == None) cursor++;
+
+    std::uint32_t& head = heads[cursor % BucketCount];
+    const Entry& e = entries[head];
+    head = e.next;
+    count--;
+    return e.cell;
+}
+
+std::size_t GridPathfinder::BucketQueue::bytes() const {
+    return vectorBytes(heads) + vectorBytes(entries);
+}
+
+
+GridPathfinder::GridPathfinder(const NavGrid& gr)
+    : grid(gr), stamp(0), expanded(0) {}
+
+void GridPathfinder::beginSearch() {
+    if (seen.size() != grid.size()) {
+        g.assign(grid.size(), 0);
+        parent.assign(grid.size(), 0);
+        seen.assign(grid.size(), 0);
+        closed.assign(grid.size(), 0);
+        stamp = 0;
+    }
+
+    //once every 4 billion searches, the stamps wrap and really need clearing
+    if (++stamp == 0) {
+        std::fill(seen.begin(), seen.end(), 0);
+        std::fill(closed.begin(), closed.end(), 0);
+        stamp = 1;
+    }
+    expanded = 0;
+}
+
+bool GridPathfinder::findPath(Coord from, Coord to, std::vector<Coord>& path, std::size_t maxExpanded) {
+    if (!grid.passable(from) || !grid.passable(to)) return false;
+
+    beginSearch();
+    std::uint32_t start = grid.index(from), goal = grid.index(to);
+
+    g[start] = 0;
+    seen[start] = stamp;
+    open.reset(grid.estimate(start, goal));
+    open.push(grid.estimate(start, goal), start);
+
+    bool found = false;
+    while (!open.empty()) {
+        std::uint32_t cell = open.pop();
+        //cells are pushed again when a cheaper way to them turns up, rather than moved; skip the stale entries
+        if (closed[cell] == stamp) continue;
+        closed[cell] = stamp;
+
+        if (cell == goal) {
+            found = true;
+            break;
+        }
+        if (++expanded > maxExpanded) break;
+
+        grid.forEachMove(cell, [&] (std::uint32_t next, int d) {
+            if (closed[next] == stamp) return;
+
+            std::uint32_t cost = g[cell] + NavGrid::length(d) * grid.cost(next);
+            if (seen[next] == stamp && g[next] <= cost) return;
+
+            seen[next] = stamp;
+            g[next] = cost;
+            parent[next] = cell;
+            open.push(cost + grid.estimate(next, goal), next);
+        });
+    }
+    if (!found) return false;
+
+    std::size_t first = path.size();
+    for (std::uint32_t cell = goal; ; cell = parent[cell]) {
+        path.push_back(grid.coord(cell));
+        if (cell == start) break;
+    }
+    std::reverse(path.begin() + first, path.end());
+    return true;
+}
+
+void GridPathfinder::buildFlowField(Coord goal, FlowField& out) {
+    out.target = goal;
+    out.w = grid.width();
+    out.h = grid.height();
+    out.builtFrom = grid.version();
+    out.dist.assign(grid.size(), FlowField::Unreachable);
+    out.dir.assign(grid.size(), -1);
+    if (!grid.passable(goal)) return;
+
+    beginSearch();
+    std::uint32_t start = grid.index(goal);
+
+    //Dijkstra out of the goal over reversed moves: stepping from next onto cell costs cell's cost, and moves
+    // (blocked corners included) are symmetric, so a move out of cell in direction d is one into it in 7 - d
+    out.dist[start] = 0;
+    open.reset(0);
+    open.push(0, start);
+
+    while (!open.empty()) {
+        std::uint32_t cell = open.pop();
+        if (closed[cell] == stamp) continue;
+        closed[cell] = stamp;
+        expanded++;
+
+        grid.forEachMove(cell, [&] (std::uint32_t next, int d) {
+            if (closed[next] == stamp) return;
+
+            std::uint32_t cost = out.dist[cell] + NavGrid::length(d) * grid.cost(cell);
+            if (out.dist[next] <= cost) return;
+
+            out.dist[next] = cost;
+            out.dir[next] = std::int8_t(7 - d);
+            open.push(cost, next);
+        });
+    }
+}
+
+MemoryReport GridPathfinder::memoryReport() const {
+    MemoryReport out("GridPathfinder");
+    out.add("cells", vectorBytes(g) + vectorBytes(parent) + vectorBytes(seen) + vectorBytes(closed));
+    out.add("open", open.bytes());
+    return out;
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+#include "vec2.h"
+#include "memory.h"
+
+///a flat width x height grid of movement costs, row-major: 0 is blocked, 1-255 is the cost of entering the cell
+/// (ex: 1 road, 4 swamp). Moves are 8-way; a move costs its length (10 straight, 14 diagonal) times the entered
+/// cell's cost, and diagonals can't cut past a blocked cell
+class NavGrid {
+    public:
+    static constexpr std::uint32_t StraightLength = 10;
+    static constexpr std::uint32_t DiagonalLength = 14;
+
+    NavGrid(int width, int height, std::uint8_t cost = 1);
+
+    int width() const { return w; }
+    int height() const { return h; }
+    std::size_t size() const { return costs.size(); }
+
+    bool contains(Coord c) const { return c.x >= 0 && c.y >= 0 && c.x < w && c.y < h; }
+    std::uint32_t index(Coord c) const { return std::uint32_t(c.y) * w + c.x; }
+    Coord coord(std::uint32_t i) const { return Coord(i % w, i / w); }
+
+    std::uint8_t cost(Coord c) const { return costs[index(c)]; }
+    std::uint8_t cost(std::uint32_t i) const { return costs[i]; }
+    bool passable(Coord c) const { return contains(c) && costs[index(c)] != 0; }
+
+    void setCost(Coord c, std::uint8_t cost);
+    ///counts setCost calls, so flow fields and cached paths can tell they're stale
+    std::uint64_t version() const { return changes; }
+
+    ///the 8 directions, in Coord::getNeighbors order; direction 7 - d is the opposite of d
+    static Coord direction(int d);
+    static std::uint32_t length(int d) { return d == 0 || d == 2 || d == 5 || d == 7 ? DiagonalLength : StraightLength; }
+
+    ///f(std::uint32_t to, int direction) for every move out of cell i onto a passable cell, without allocating
+    template <class F>
+    void forEachMove(std::uint32_t i, F f) const {
+        int x = i % w, y = i / w;
+        bool left = x > 0, right = x + 1 < w, up = y > 0, down = y + 1 < h;
+
+        bool open[8] = {
+            left && up && costs[i - w - 1] && costs[i - 1] && costs[i - w],
+            up && costs[i - w],
+            right && up && costs[i - w + 1] && costs[i + 1] && costs[i - w],
+            left && costs[i - 1],
+            right && costs[i + 1],
+            left && down && costs[i + w - 1] && costs[i - 1] && costs[i + w],
+            down && costs[i + w],
+            right && down && costs[i + w + 1] && costs[i + 1] && costs[i + w]
+        };
+        const std::int64_t step[8] = {-w - 1, -w, -w + 1, -1, 1, w - 1, w, w + 1};
+
+        for (int d = 0; d < 8; d++) {
+            if (open[d]) f(std::uint32_t(i + step[d]), d);
+        }
+    }
+
+    ///admissible estimate of the cost from a to b (octile distance at the cheapest cost)
+    std::uint32_t estimate(std::uint32_t a, std::uint32_t b) const;
+
+    MemoryReport memoryReport() const;
+
+    private:
+    int w, h;
+    std::vector<std::uint8_t> costs;
+    std::uint64_t changes;
+};
+
+///distance to one goal and the next step toward it from every cell, from one Dijkstra pass out of the goal;
+/// one field serves every agent heading there, however many
+class FlowField {
+    public:
+    static constexpr std::uint32_t Unreachable = std::numeric_limits<std::uint32_t>::max();
+
+    FlowField();
+
+    Coord goal() const { return target; }
+    bool reachable(Coord c) const { return contains(c) && dist[index(c)] != Unreachable; }
+    ///cost of the cheapest path from c to the goal, or Unreachable
+    std::uint32_t distance(Coord c) const { return contains(c) ? dist[index(c)] : Unreachable; }
+    ///the neighbor to move to from c; c itself at the goal, or if the goal can't be reached from c
+    Coord next(Coord c) const;
+
+    ///the NavGrid::version it was built from
+    std::uint64_t version() const { return builtFrom; }
+
+    std::size_t bytes() const { return vectorBytes(dist) + vectorBytes(dir); }
+
+    private:
+    friend class GridPathfinder;
+
+    Coord target;
+    int w, h;
+    std::uint64_t builtFrom;
+    std::vector<std::uint32_t> dist;
+    ///NavGrid direction toward the goal, or -1
+    std::vector<std::int8_t> dir;
+
+    bool contains(Coord c) const { return c.x >= 0 && c.y >= 0 && c.x < w && c.y < h; }
+    std::uint32_t index(Coord c) const { return std::uint32_t(c.y) * w + c.x; }
+};
+
+///A* and flow fields over a NavGrid. Searches reuse the pathfinder's per-cell buffers (cleared by bumping a stamp,
+/// not by a pass over the grid) and a bucket open list, so after the first search they don't allocate
+///one pathfinder per thread; the grid mustn't change while it searches
+class GridPathfinder {
+    public:
+    GridPathfinder(const NavGrid& g);
+
+    ///appends the cells from from to to (both included) to path; returns false, leaving path alone, if to can't be
+    /// reached (including when either end is blocked), or if that's not known after expanding maxExpanded cells
+    bool findPath(Coord from, Coord to, std::vector<Coord>& path,
+                  std::size_t maxExpanded = std::numeric_limits<std::size_t>::max());
+
+    ///fills out for goal, reusing its buffers
+    void buildFlowField(Coord goal, FlowField& out);
+
+    ///cells the last search expanded
+    std::size_t lastExpanded() const { return expanded; }
+
+    MemoryReport memoryReport() const;
+
+    private:
+    ///a monotone priority queue of cells: one bucket per key, in a ring as wide as the most a key can grow per
+    /// expansion, so push and pop are O(1) and popping walks each key once
+    class BucketQueue {
+        public:
+        BucketQueue();
+
+        void reset(std::uint32_t startKey);
+        ///key must be >= the last popped key, and within the ring's width of it
+        void push(std::uint32_t key, std::uint32_t cell);
+        bool empty() const { return count == 0; }
+        ///one of the lowest keyed cells; cells pushed twice come out twice
+        std::uint32_t pop();
+        std::uint32_t key() const { return cursor; }
+
+        std::size_t bytes() const;
+
+        private:
+        struct Entry {
+            std::uint32_t cell;
+            std::uint32_t next;
+        };
+
+        ///each bucket is a list threaded through entries (which only grows during a search), so the buckets
+        /// themselves are one index each
+        std::vector<std::uint32_t> heads;
+        std::vector<Entry> entries;
+        std::uint32_t cursor;
+        std::size_t count;
+    };
+
+    const NavGrid& grid;
+
+    std::vector<std::uint32_t> g;
+    std::vector<std::uint32_t> parent;
+    ///a cell's g and parent are only valid when its seen stamp is this search's
+    std::vector<std::uint32_t> seen;
+    std::vector<std::uint32_t> closed;
+    std::uint32_t stamp;
+
+    BucketQueue open;
+    std::size_t expanded;
+
+    void beginSearch();
+};
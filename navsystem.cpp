@@ -0,0 +1,167 @@
+#include "navsystem.h"
+
+#include <algorithm>
+
+NavSystem::NavSystem(std::function<Entity*(EntityID)> idToEntity, const NavGrid& g, std::size_t flowFieldThreshold)
+    : SimpleSystem(idToEntity), grid(g), pathfinder(g), flowThreshold(flowFieldThreshold),
+      searchLimit(std::numeric_limits<std::size_t>::max()) {}
+
+void NavSystem::requestPath(EntityID eID, Coord from, Coord goal) {
+    requests.push_back(Request{eID, from, goal});
+}
+
+void NavSystem::customUpdate() {
+    solved.clear();
+
+    //keep each entity's last request
+    std::stable_sort(requests.begin(), requests.end(), [] (const Request& a, const Request& b) { return a.eID < b.eID; });
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < requests.size(); i++) {
+        bool last = i + 1 == requests.size() || requests[i + 1].eID != requests[i].eID;
+        if (last && modules.count(requests[i].eID) > 0) requests[kept++] = requests[i];
+    }
+    requests.erase(requests.begin() + kept, requests.end());
+
+    //then solve them a goal at a time
+    auto byGoal = [] (const Request& a, const Request& b) {
+        return a.goal.y < b.goal.y || (a.goal.y == b.goal.y && a.goal.x < b.goal.x);
+    };
+    std::stable_sort(requests.begin(), requests.end(), byGoal);
+
+    for (std::size_t i = 0; i < requests.size();) {
+        std::size_t j = i + 1;
+        while (j < requests.size() && requests[j].goal == requests[i].goal) j++;
+
+        const Request* begin = requests.data() + i;
+        const Request* end = requests.data() + j;
+        bool shared = grid.passable(begin->goal)
+                      && (j - i >= flowThreshold || fields.count(grid.index(begin->goal)) > 0);
+
+        if (shared) solveFlow(begin, end);
+        else solvePaths(begin, end);
+        i = j;
+    }
+    requests.clear();
+
+    //drop fields nobody follows any more, and rebuild the rest if the grid changed under them
+    for (auto it = fields.begin(); it != fields.end();) {
+        if (it->second.followers == 0) {
+            it = fields.erase(it);
+            continue;
+        }
+
+        Field& f = it->second;
+        if (!f.built || f.field.version() != grid.version()) {
+            pathfinder.buildFlowField(grid.coord(it->first), f.field);
+            f.built = true;
+        }
+        ++it;
+    }
+}
+
+void NavSystem::solveFlow(const Request* begin, const Request* end) {
+    std::uint32_t goal = grid.index(begin->goal);
+    Field& f = fields[goal];
+    if (!f.built || f.field.version() != grid.version()) {
+        pathfinder.buildFlowField(begin->goal, f.field);
+        f.built = true;
+    }
+
+    for (const Request* r = begin; r != end; r++) {
+        NavAgent& agent = *modules.at(r->eID);
+        agent.goal = r->goal;
+        agent.path.clear();
+
+        if (f.field.reachable(r->from)) {
+            follow(r->eID, goal);
+            finish(r->eID, agent, NavStatus::Flow);
+        }
+        else {
+            unfollow(r->eID);
+            finish(r->eID, agent, NavStatus::Unreachable);
+        }
+    }
+}
+
+void NavSystem::solvePaths(const Request* begin, const Request* end) {
+    for (const Request* r = begin; r != end; r++) {
+        NavAgent& agent = *modules.at(r->eID);
+        agent.goal = r->goal;
+        agent.path.clear();
+        unfollow(r->eID);
+
+        bool found = pathfinder.findPath(r->from, r->goal, agent.path, searchLimit);
+        finish(r->eID, agent, found ? NavStatus::Path : NavStatus::Unreachable);
+    }
+}
+
+void NavSystem::finish(EntityID eID, NavAgent& agent, NavStatus status) {
+    agent.status = status;
+    touch(eID);
+    solved.push_back(NavResult{eID, status});
+}
+
+const FlowField* NavSystem::flowField(EntityID eID) const {
+    auto it = following.find(eID);
+    if (it == following.end()) return nullptr;
+
+    const Field& f = fields.at(it->second);
+    return f.built ? &f.field : nullptr;
+}
+
+void NavSystem::postCreate(EntityID eID) {
+    //snapshots and journal recovery bring back agents that were following a field
+    auto it = modules.find(eID);
+    if (it == modules.end()) return;
+
+    const NavAgent& agent = *it->second;
+    if (agent.status == NavStatus::Flow && grid.contains(agent.goal)) follow(eID, grid.index(agent.goal));
+    else unfollow(eID);
+}
+
+void NavSystem::preDestroy(EntityID eID) {
+    unfollow(eID);
+}
+
+MemoryReport NavSystem::memoryReport() const {
+    MemoryReport out = SimpleSystem::memoryReport();
+    out.add("requests", vectorBytes(requests) + vectorBytes(solved));
+
+    std::size_t fieldBytes = hashContainerBytes(fields);
+    for (auto& f : fields) fieldBytes += f.second.field.bytes();
+    out.add("flow fields", fieldBytes);
+    out.add("following", hashContainerBytes(following));
+
+    out.children.push_back(pathfinder.memoryReport());
+    return out;
+}
+
+void NavSystem::compact() {
+    SimpleSystem::compact();
+
+    shrinkVector(requests);
+    shrinkVector(solved);
+    shrinkHashContainer(fields);
+    shrinkHashContainer(following);
+}
+
+void NavSystem::follow(EntityID eID, std::uint32_t goal) {
+    auto it = following.find(eID);
+    if (it != following.end()) {
+        if (it->second == goal) return;
+        fields[it->second].followers--;
+        it->second = goal;
+    }
+    else {
+        following.emplace(eID, goal);
+    }
+    fields[goal].followers++;
+}
+
+void NavSystem::unfollow(EntityID eID) {
+    auto it = following.find(eID);
+    if (it == following.end()) return;
+
+    fields[it->second].followers--;
+    following.erase(it);
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+#include "component.h"
+#include "codec.h"
+#include "navgrid.h"
+
+enum class NavStatus : std::uint8_t {
+    ///nothing requested yet
+    Idle,
+    ///path holds the route, start and goal included
+    Path,
+    ///following the shared flow field to goal (see NavSystem::flowField)
+    Flow,
+    ///the last request's goal can't be reached from where it started
+    Unreachable
+};
+
+struct NavAgent {
+    NavStatus status = NavStatus::Idle;
+    Coord goal;
+    std::vector<Coord> path;
+};
+
+///lets a Journal record agents: status, goal, then the path's length and cells
+template<> struct JournalCodec<NavAgent> {
+    static constexpr bool supported = true;
+
+    static void encode(const NavAgent& a, std::vector<char>& out) {
+        encodePOD<std::uint8_t>(std::uint8_t(a.status), out);
+        encodePOD<Coord>(a.goal, out);
+        encodePOD<std::uint32_t>(a.path.size(), out);
+        for (auto& c : a.path) encodePOD<Coord>(c, out);
+    }
+
+    static NavAgent decode(const char* data, std::size_t size) {
+        std::size_t offset = 0;
+        NavAgent out;
+        out.status = NavStatus(decodePOD<std::uint8_t>(data, offset));
+        out.goal = decodePOD<Coord>(data, offset);
+
+        std::uint32_t length = decodePOD<std::uint32_t>(data, offset);
+        out.path.reserve(length);
+        for (std::uint32_t i = 0; i < length; i++) out.path.push_back(decodePOD<Coord>(data, offset));
+        return out;
+    }
+};
+
+typedef TypedPartialComponent<NavAgent, SystemType::Nav> NavAgentPC;
+
+struct NavResult {
+    EntityID eID;
+    NavStatus status;
+};
+
+///routes entities with a NavAgent over a NavGrid. Requests queue up during the frame and are solved together in
+/// update(): a goal requested by at least flowFieldThreshold agents (or that already has a flow field) gets one
+/// shared FlowField instead of a path each; the rest get A* paths. Either way the result lands in the agent's
+/// module (touch()ed) and in results(), ex:
+///  NavSystem nav(ID2ENT, grid);                          //in a World's constructor
+///  world.makeEntity(p, new NavAgentPC(NavAgent()));
+///  nav.requestPath(eid, here, there);                    //any time during the frame
+///  nav.update();                                         //in customUpdate
+///  for (auto& r : nav.results()) ...                     //until the next update
+///flow fields live while an agent follows them, and are rebuilt at the next update after the grid changes; paths
+/// aren't, so request again after changing the grid under them
+class NavSystem : public SimpleSystem<NavAgent, SystemType::Nav> {
+    public:
+    NavSystem(std::function<Entity*(EntityID)> idToEntity, const NavGrid& g, std::size_t flowFieldThreshold = 8);
+
+    ///solved at the next update; a later request for the same entity replaces this one, and requests for entities
+    /// without a NavAgent by then are dropped
+    void requestPath(EntityID eID, Coord from, Coord goal);
+
+    void customUpdate();
+
+    ///the requests solved by the last update, grouped by goal
+    const std::vector<NavResult>& results() const { return solved; }
+
+    ///the field eID follows, or nullptr if it isn't following one (or it's not built yet); valid until the next update
+    const FlowField* flowField(EntityID eID) const;
+
+    ///cells a single A* search may expand before giving up (its agent is then Unreachable)
+    void setSearchLimit(std::size_t maxExpanded) { searchLimit = maxExpanded; }
+
+    void postCreate(EntityID eID);
+    void preDestroy(EntityID eID);
+    void preRemove(EntityID eID) { preDestroy(eID); }
+
+    std::size_t instanceHeapBytes(const NavAgent& a) const { return vectorBytes(a.path); }
+    MemoryReport memoryReport() const;
+    void compact();
+
+    private:
+    struct Request {
+        EntityID eID;
+        Coord from;
+        Coord goal;
+    };
+
+    struct Field {
+        FlowField field;
+        std::size_t followers = 0;
+        bool built = false;
+    };
+
+    const NavGrid& grid;
+    GridPathfinder pathfinder;
+    std::size_t flowThreshold;
+    std::size_t searchLimit;
+
+    std::vector<Request> requests;
+    std::vector<NavResult> solved;
+
+    ///by goal cell index
+    std::unordered_map<std::uint32_t, Field> fields;
+    ///each flow agent's goal cell index
+    std::unordered_map<EntityID, std::uint32_t> following;
+
+    void solveFlow(const Request* begin, const Request* end);
+    void solvePaths(const Request* begin, const Request* end);
+    void finish(EntityID eID, NavAgent& agent, NavStatus status);
+
+    void follow(EntityID eID, std::uint32_t goal);
+    void unfollow(EntityID eID);
+};
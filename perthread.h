@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+
+#include "memory.h"
+
+///one T per thread that uses it (ex: a producer thread's buffer, merged by the update thread at frame boundaries)
+///local() finds the calling thread's T through a thread_local cache, so only a thread's first call locks.
+/// Cache entries can outlive their PerThread; each cache miss drops the entries of destroyed PerThreads, so a
+/// long-lived thread doesn't keep one entry for every World it ever touched
+template <class T>
+class PerThread {
+    public:
+    PerThread()
+        : id(makeID()) {}
+
+    PerThread(const PerThread&) = delete;
+    PerThread& operator= (const PerThread&) = delete;
+
+    T& local() {
+        std::vector<CacheEntry>& cache = threadCache();
+        for (auto& c : cache) if (c.id == id) return *c.value;
+
+        auto dead = [] (const CacheEntry& c) { return c.alive.expired(); };
+        cache.erase(std::remove_if(cache.begin(), cache.end(), dead), cache.end());
+
+        std::lock_guard<std::mutex> lock(mutex);
+        //not make_shared: the cache's weak_ptr would keep a dead T's storage around until its next miss
+        values.push_back(std::shared_ptr<T>(new T()));
+        cache.push_back(CacheEntry{id, values.back().get(), values.back()});
+        return *values.back();
+    }
+
+    ///every thread's T, under the registration lock; owners write theirs without it, so call only while they don't
+    template <class F>
+    void forEach(F func) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& v : values) func(*v);
+    }
+
+    template <class F>
+    void forEach(F func) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& v : values) func(static_cast<const T&>(*v));
+    }
+
+    ///the Ts themselves and their bookkeeping, not counting anything the Ts own
+    std::size_t bytes() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return vectorBytes(values) + values.size() * (sizeof(T) + sharedControlBlockBytes());
+    }
+
+    ///entries in the calling thread's cache, across every PerThread<T>; for tests
+    static std::size_t cachedOnThisThread() { return threadCache().size(); }
+
+    private:
+    struct CacheEntry {
+        std::uint64_t id;
+        T* value;
+        std::weak_ptr<T> alive;
+    };
+
+    ///never reused, so a cache entry is never matched by a later PerThread at the same address
+    std::uint64_t id;
+    mutable std::mutex mutex;
+    std::vector<std::shared_ptr<T>> values;
+
+    static std::uint64_t makeID() {
+        static std::atomic<std::uint64_t> next(0);
+        return next++;
+    }
+
+    static std::vector<CacheEntry>& threadCache() {
+        thread_local std::vector<CacheEntry> cache;
+        return cache;
+    }
+};
@@ -0,0 +1,73 @@
+#include "examplegame.h"
+#include "snapshot.h"
+
+#include <chrono>
+#include <string>
+#include <cstdio>
+#include <iostream>
+
+///save/load/duplicate on a POD-only world (HealthValue and BuffValue opt in to RawModuleCopy), comparing the
+/// per-entity SavedEntity paths to the system-major snapshot paths, which copy rawCopyModules columns as is
+/// ex: ./podBenchmark 200000
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double msSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    std::vector<EntityID> populate(ExampleGameWorld& world, int count) {
+        std::vector<EntityID> out;
+        out.reserve(count);
+
+        for (int i = 0; i < count; i++) {
+            out.push_back(world.makeEntity(Placement(), new HealthPC(HealthValue(100.)),
+                                           new BuffPC(BuffValue{1., 5.}), new BuffPC(BuffValue{2., 10.})));
+        }
+        return out;
+    }
+
+    template <class F>
+    double timed(F f) {
+        auto start = Clock::now();
+        f();
+        return msSince(start);
+    }
+
+    void row(const char* op, double perEntity, double systemMajor) {
+        std::printf("%s,%.2f,%.2f,%.2f\n", op, perEntity, systemMajor, perEntity / systemMajor);
+    }
+}
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? std::stoi(argv[1]) : 100000;
+
+    //every measurement gets a freshly populated world, so container growth is the same for both paths
+    ExampleGameWorld source;
+    std::vector<EntityID> ids = populate(source, count);
+
+    std::vector<SavedEntity> saved;
+    WorldSnapshot snapshot;
+
+    std::printf("op,per_entity_ms,system_major_ms,speedup\n");
+
+    row("save", timed([&] { saved = source.saveEntities(ids); }),
+                timed([&] { snapshot = source.snapshot(ids); }));
+
+    {
+        ExampleGameWorld a, b;
+        row("load", timed([&] { a.loadEntities(saved); }),
+                    timed([&] { b.loadSnapshot(snapshot); }));
+    }
+
+    {
+        ExampleGameWorld a, b;
+        populate(a, count);
+        populate(b, count);
+        row("duplicate", timed([&] { a.duplicateEntities(saved); }),
+                         timed([&] { b.duplicateSnapshot(snapshot); }));
+    }
+
+    return 0;
+}
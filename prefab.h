@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "component.h"
+
+class WorldBase;
+
+///a component list compiled against one World: System lookup, casting and validation happen once in
+/// WorldBase::compilePrefab, so WorldBase::instantiate only copies each Template into its System
+///only valid for the World that compiled it, and only while that World's Systems are alive
+class Prefab {
+    std::vector<std::unique_ptr<IBoundComponent>> components;
+    ///deduped, in first-use order
+    std::vector<SystemBase*> systems;
+    const WorldBase* world;
+
+    Prefab(const WorldBase* w)
+        : world(w) {}
+
+    friend class WorldBase;
+
+    public:
+    Prefab(Prefab&&) = default;
+    Prefab& operator= (Prefab&&) = default;
+
+    std::size_t componentCount() const { return components.size(); }
+};
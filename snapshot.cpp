@@ -0,0 +1,75 @@
+#include "snapshot.h"
+
+#include <unordered_map>
+#include <algorithm>
+
+std::size_t WorldSnapshot::moduleCount() const {
+    std::size_t out = 0;
+    for (auto& c : columns) out += c->size();
+    return out;
+}
+
+std::size_t WorldSnapshot::bytes() const {
+    std::size_t out = vectorBytes(placements) + vectorBytes(columns);
+    for (auto& c : columns) out += c->bytes();
+    return out;
+}
+
+void WorldSnapshot::sortByEntity() {
+    std::sort(placements.begin(), placements.end(), [] (const auto& a, const auto& b) { return a.first < b.first; });
+}
+
+std::vector<SavedEntity> WorldSnapshot::toSavedEntities(std::atomic<std::size_t>* progress) const {
+    std::vector<SavedEntity> out;
+    out.reserve(placements.size());
+
+    std::unordered_map<EntityID, std::size_t> index;
+    index.reserve(placements.size());
+
+    for (auto& p : placements) {
+        index.insert(std::make_pair(p.first, out.size()));
+        out.push_back(SavedEntity(p.first, std::vector<std::shared_ptr<IPartialComponent>>(), p.second));
+    }
+
+    for (auto& c : columns) {
+        for (std::size_t i = 0; i < c->size(); i++) {
+            out[index.at(c->eid(i))].components.push_back(c->recreatePartialComponent(i));
+            if (progress) (*progress)++;
+        }
+    }
+
+    return out;
+}
+
+
+AsyncSave::AsyncSave(WorldSnapshot&& s, Writer w)
+    : snapshot(std::move(s)), writer(w), modulesDone(0), modulesTotal(snapshot.moduleCount()), finished(false),
+      worker(&AsyncSave::run, this) {}
+
+AsyncSave::~AsyncSave() {
+    if (worker.joinable()) worker.join();
+}
+
+void AsyncSave::run() {
+    try {
+        snapshot.sortByEntity();
+        writer(snapshot.toSavedEntities(&modulesDone));
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+
+    finished = true;
+}
+
+double AsyncSave::progress() const {
+    if (finished) return 1.;
+
+    //the last step is the writer itself
+    return (double) modulesDone / (double) (modulesTotal + 1);
+}
+
+void AsyncSave::wait() {
+    if (worker.joinable()) worker.join();
+    if (error) std::rethrow_exception(error);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <exception>
+#include <functional>
+
+#include "component.h"
+#include "actor.h"
+
+///a consistent point-in-time image of a World: every Entity's Placement, plus one column per System
+/// taking it is a block copy per System; turning it into SavedEntities can happen later, on any thread
+struct WorldSnapshot {
+    std::vector<std::pair<EntityID, Placement>> placements;
+    std::vector<std::unique_ptr<IModuleColumn>> columns;
+
+    std::size_t moduleCount() const;
+    std::size_t bytes() const;
+
+    ///placements are in World iteration order; AsyncSave sorts them off-thread
+    void sortByEntity();
+
+    ///same result as saveEntities over every entity, in placements order
+    /// progress (if given) is incremented once per module converted
+    std::vector<SavedEntity> toSavedEntities(std::atomic<std::size_t>* progress = nullptr) const;
+};
+
+///builds SavedEntities from a snapshot and hands them to a writer (ex: serialize to disk) on a background thread
+class AsyncSave {
+    public:
+    typedef std::function<void(std::vector<SavedEntity>&&)> Writer;
+
+    AsyncSave(WorldSnapshot&& snapshot, Writer writer);
+    ///waits for the save to finish
+    ~AsyncSave();
+
+    AsyncSave(const AsyncSave&) = delete;
+    AsyncSave& operator= (const AsyncSave&) = delete;
+
+    ///[0, 1]; 1 once the writer has returned
+    double progress() const;
+    bool done() const { return finished; }
+
+    ///blocks until done; rethrows anything the conversion or writer threw
+    void wait();
+
+    private:
+    WorldSnapshot snapshot;
+    Writer writer;
+
+    std::atomic<std::size_t> modulesDone;
+    std::size_t modulesTotal;
+    std::atomic<bool> finished;
+    std::exception_ptr error;
+
+    std::thread worker;
+
+    void run();
+};
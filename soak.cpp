@@ -0,0 +1,267 @@
+#include "examplegame.h"
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
+///soak test: runs a churning ExampleGameWorld for a while and reports frame time percentiles, RSS and counts as CSV
+/// ex: ./soakTest --minutes 10 --spawn-rate 500 --buffs 4 --saves-per-minute 2 --csv run.csv
+///every option is `--name value`; see Config for the defaults
+///frames are paced to real time (one 1/60s step per 1/60s, catching up back to back after slow frames), so the
+/// rates below are per real second and the churn doesn't depend on how fast the host is
+
+namespace {
+    struct Config {
+        ///simulated minutes, which pacing makes wall-clock minutes too unless frames can't keep up
+        double minutes = 1.;
+        ///entities spawned per simulated second
+        double spawnRate = 200.;
+        ///mean entity lifetime in simulated seconds
+        double lifetime = 20.;
+        ///exp, uniform (0 to 2x the mean) or fixed
+        std::string lifetimeDist = "exp";
+        ///Buffs modules per spawned entity (MultiSystem fan-out)
+        int buffs = 2;
+        double buffDps = 1.;
+        double savesPerMinute = 1.;
+        ///sync (saveEntities on the update thread) or async (snapshot + saveAsync)
+        std::string saveMode = "async";
+        double duplicatesPerMinute = 30.;
+        ///entities copied per duplication
+        int duplicateBatch = 50;
+        ///wall-clock seconds per CSV row
+        double interval = 5.;
+        unsigned seed = 1;
+        std::string csv;
+    };
+
+    Config parseArgs(int argc, char** argv) {
+        Config c;
+        for (int i = 1; i < argc; i++) {
+            std::string name = argv[i];
+            if (name.rfind("--", 0) != 0 || i + 1 >= argc) throw std::invalid_argument("expected --name value, got " + name);
+            std::string value = argv[++i];
+
+            if (name == "--minutes") c.minutes = std::stod(value);
+            else if (name == "--spawn-rate") c.spawnRate = std::stod(value);
+            else if (name == "--lifetime") c.lifetime = std::stod(value);
+            else if (name == "--lifetime-dist") c.lifetimeDist = value;
+            else if (name == "--buffs") c.buffs = std::stoi(value);
+            else if (name == "--buff-dps") c.buffDps = std::stod(value);
+            else if (name == "--saves-per-minute") c.savesPerMinute = std::stod(value);
+            else if (name == "--save-mode") c.saveMode = value;
+            else if (name == "--duplicates-per-minute") c.duplicatesPerMinute = std::stod(value);
+            else if (name == "--duplicate-batch") c.duplicateBatch = std::stoi(value);
+            else if (name == "--interval") c.interval = std::stod(value);
+            else if (name == "--seed") c.seed = std::stoul(value);
+            else if (name == "--csv") c.csv = value;
+            else throw std::invalid_argument("unknown option " + name);
+        }
+
+        if (c.lifetimeDist != "exp" && c.lifetimeDist != "uniform" && c.lifetimeDist != "fixed") {
+            throw std::invalid_argument("--lifetime-dist must be exp, uniform or fixed");
+        }
+        if (c.saveMode != "sync" && c.saveMode != "async") throw std::invalid_argument("--save-mode must be sync or async");
+        return c;
+    }
+
+    ///frame times in 1us buckets up to 1s, so a long run doesn't grow its own RSS
+    class FrameHistogram {
+        std::vector<std::uint32_t> buckets;
+        std::uint64_t frames;
+        double maxSeconds;
+
+        public:
+        FrameHistogram()
+            : buckets(1000000, 0), frames(0), maxSeconds(0.) {}
+
+        void add(double seconds) {
+            std::size_t us = std::min<std::size_t>(std::size_t(seconds * 1e6), buckets.size() - 1);
+            buckets[us]++;
+            frames++;
+            maxSeconds = std::max(maxSeconds, seconds);
+        }
+
+        ///in milliseconds
+        double percentile(double p) const {
+            if (frames == 0) return 0.;
+
+            std::uint64_t rank = std::uint64_t(p * (frames - 1));
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < buckets.size(); i++) {
+                seen += buckets[i];
+                if (seen > rank) return (i + 0.5) / 1000.;
+            }
+            return maxSeconds * 1000.;
+        }
+
+        double maxMs() const { return maxSeconds * 1000.; }
+        std::uint64_t count() const { return frames; }
+
+        void reset() {
+            std::fill(buckets.begin(), buckets.end(), 0);
+            frames = 0;
+            maxSeconds = 0.;
+        }
+    };
+
+    double rssMB() {
+#ifdef __unix__
+        std::ifstream statm("/proc/self/statm");
+        std::size_t size = 0, resident = 0;
+        if (statm >> size >> resident) return double(resident) * sysconf(_SC_PAGESIZE) / (1024. * 1024.);
+#endif
+        return 0.;
+    }
+
+    ///entities by despawn time; a plain heap so duplication can sample live entities from it
+    struct Expiry {
+        double at;
+        EntityID eID;
+
+        bool operator> (const Expiry& other) const { return at > other.at; }
+    };
+}
+
+int main(int argc, char** argv) {
+    Config config;
+    try {
+        config = parseArgs(argc, argv);
+    }
+    catch (const std::exception& e) {
+        std::cerr<<e.what()<<std::endl;
+        return 1;
+    }
+
+    std::FILE* out = config.csv.empty() ? stdout : std::fopen(config.csv.c_str(), "w");
+    if (out == nullptr) {
+        std::cerr<<"couldn't open "<<config.csv<<std::endl;
+        return 1;
+    }
+
+    ExampleGameWorld world;
+    std::mt19937 rng(config.seed);
+    std::exponential_distribution<double> expLifetime(1. / config.lifetime);
+    std::uniform_real_distribution<double> unit(0., 1.);
+
+    auto lifetime = [&] () {
+        if (config.lifetimeDist == "exp") return expLifetime(rng);
+        if (config.lifetimeDist == "uniform") return unit(rng) * 2. * config.lifetime;
+        return config.lifetime;
+    };
+
+    std::vector<Expiry> expiries;
+    auto track = [&] (EntityID eID, double at) {
+        expiries.push_back(Expiry{at, eID});
+        std::push_heap(expiries.begin(), expiries.end(), std::greater<Expiry>());
+    };
+
+    const double dt = 1. / 60.;
+    double simTime = 0.;
+    double spawnDebt = 0.;
+    double saveDebt = 0.;
+    double duplicateDebt = 0.;
+
+    std::vector<std::unique_ptr<AsyncSave>> saves;
+    std::vector<EntityID> toDuplicate;
+
+    FrameHistogram interval, total;
+
+    std::fprintf(out, "scope,time_s,frames,entities,health_modules,buff_modules,p50_ms,p99_ms,p999_ms,max_ms,rss_mb\n");
+    auto report = [&] (const char* scope, double t, const FrameHistogram& h) {
+        std::fprintf(out, "%s,%.1f,%llu,%zu,%zu,%zu,%.3f,%.3f,%.3f,%.3f,%.1f\n", scope, t, (unsigned long long) h.count(),
+            world.entityCount(), world.healthSystem.moduleCount(), world.buffSystem.moduleCount(),
+            h.percentile(0.5), h.percentile(0.99), h.percentile(0.999), h.maxMs(), rssMB());
+        std::fflush(out);
+    };
+
+    typedef std::chrono::steady_clock Clock;
+    auto start = Clock::now();
+    auto nextReport = config.interval;
+    auto elapsed = [&] () { return std::chrono::duration<double>(Clock::now() - start).count(); };
+    auto step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(dt));
+    auto nextFrame = start;
+
+    while (simTime < config.minutes * 60.) {
+        std::this_thread::sleep_until(nextFrame);
+        nextFrame += step;
+        auto frameStart = Clock::now();
+
+        //workload for this frame; all of it is timed, since it's what a game would do between updates
+        for (spawnDebt += config.spawnRate * dt; spawnDebt >= 1.; spawnDebt -= 1.) {
+            std::vector<std::shared_ptr<IPartialComponent>> components;
+            components.push_back(std::make_shared<HealthPC>(HealthValue(100.)));
+            for (int b = 0; b < config.buffs; b++) {
+                components.push_back(std::make_shared<BuffPC>(BuffValue{config.buffDps, unit(rng) * 2. * config.lifetime}));
+            }
+
+            Placement p;
+            p.pos = Vec3(unit(rng) * 100., unit(rng) * 100., 0.);
+            track(world.makeEntity(components, p), simTime + lifetime());
+        }
+
+        while (!expiries.empty() && expiries.front().at <= simTime) {
+            if (world.hasEntity(expiries.front().eID)) world.deleteEntityNextFrame(expiries.front().eID);
+            std::pop_heap(expiries.begin(), expiries.end(), std::greater<Expiry>());
+            expiries.pop_back();
+        }
+
+        for (duplicateDebt += config.duplicatesPerMinute / 60. * dt; duplicateDebt >= 1.; duplicateDebt -= 1.) {
+            toDuplicate.clear();
+            for (int i = 0; i < config.duplicateBatch && !expiries.empty(); i++) {
+                EntityID eID = expiries[std::size_t(unit(rng) * expiries.size()) % expiries.size()].eID;
+                if (world.hasEntity(eID)) toDuplicate.push_back(eID);
+            }
+            std::sort(toDuplicate.begin(), toDuplicate.end());
+            toDuplicate.erase(std::unique(toDuplicate.begin(), toDuplicate.end()), toDuplicate.end());
+
+            for (EntityID eID : world.duplicateEntities(world.saveEntities(toDuplicate))) track(eID, simTime + lifetime());
+        }
+
+        for (saveDebt += config.savesPerMinute / 60. * dt; saveDebt >= 1.; saveDebt -= 1.) {
+            if (config.saveMode == "async") {
+                saves.push_back(world.saveAsync([] (std::vector<SavedEntity>&& saved) {}));
+            }
+            else {
+                std::vector<EntityID> all;
+                all.reserve(expiries.size());
+                for (auto& e : expiries) if (world.hasEntity(e.eID)) all.push_back(e.eID);
+                world.saveEntities(all);
+            }
+        }
+        //only finished saves are dropped, so ~AsyncSave never blocks the frame
+        saves.erase(std::remove_if(saves.begin(), saves.end(), [] (const std::unique_ptr<AsyncSave>& s) {
+            return s->done();
+        }), saves.end());
+
+        world.update(dt);
+        simTime += dt;
+
+        double frameSeconds = std::chrono::duration<double>(Clock::now() - frameStart).count();
+        interval.add(frameSeconds);
+        total.add(frameSeconds);
+
+        if (elapsed() >= nextReport) {
+            report("interval", elapsed(), interval);
+            interval.reset();
+            nextReport += config.interval;
+        }
+    }
+
+    saves.clear();
+    report("total", elapsed(), total);
+
+    if (out != stdout) std::fclose(out);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include "statehash.h"
+
+#include <cstring>
+
+namespace {
+    ///splitmix64 finalizer; spreads FNV's output so XORed contributions don't cancel in structured ways
+    std::uint64_t mix(std::uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebull;
+        x ^= x >> 31;
+        return x;
+    }
+
+    const std::uint32_t placementTag = 0xFFFFFFFFu;
+
+    ///tells apart entities that held the same slot
+    std::uint64_t withGeneration(std::uint64_t seed, EntityID eID) {
+        return seed ^ mix(eID.generation());
+    }
+}
+
+std::uint64_t StateHasher::hashBytes(const char* data, std::size_t size, std::uint64_t seed) {
+    std::uint64_t h = 14695981039346656037ull ^ mix(seed);
+    for (std::size_t i = 0; i < size; i++) {
+        h ^= (unsigned char) data[i];
+        h *= 1099511628211ull;
+    }
+    return mix(h);
+}
+
+std::uint64_t StateHasher::hashPlacement(EntityID eID, const Placement& p) {
+    std::uint64_t seed = withGeneration((std::uint64_t(eID.slot()) << 32) | placementTag, eID);
+    return hashBytes(reinterpret_cast<const char*>(&p), sizeof(Placement), seed);
+}
+
+std::uint64_t StateHasher::hashModules(EntityID eID, SystemBase& sys) {
+    scratch.clear();
+    if (!sys.encodeModules(eID, scratch)) return 0;
+
+    return hashBytes(scratch.data(), scratch.size(), withGeneration(key(eID, sys.getType()), eID));
+}
+
+void StateHasher::moduleDestroyed(SystemBase& sys, EntityID eID) {
+    auto it = contributions.find(key(eID, sys.getType()));
+    if (it == contributions.end()) return;
+
+    total ^= it->second;
+    contributions.erase(it);
+}
+
+std::uint64_t StateHasher::flush() {
+    for (auto& d : dirty) {
+        if (!d.second->hasModules(d.first)) continue;
+
+        std::uint64_t& slot = contributions[key(d.first, d.second->getType())];
+        std::uint64_t h = hashModules(d.first, *d.second);
+
+        total ^= slot ^ h;
+        slot = h;
+    }
+    dirty.clear();
+
+    return total;
+}
+
+MemoryReport StateHasher::memoryReport() const {
+    MemoryReport out("StateHasher");
+    out.add("contributions", hashContainerBytes(contributions));
+    out.add("dirty", vectorBytes(dirty));
+    out.add("scratch", vectorBytes(scratch));
+    return out;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include "component.h"
+#include "3dmath.h"
+
+///incremental, order-independent hash of every module in the Systems it observes (see WorldBase::stateHash)
+/// each module contributes hash(EID, SystemType, encoded Instance); contributions are XORed, so the total
+/// doesn't depend on container iteration order
+///modules are rehashed only when created or touch()ed; modules are hashed through their JournalCodec bytes,
+/// so Instances with padding should specialize JournalCodec to write fields only
+class StateHasher : public ModuleObserver {
+    public:
+    static std::uint64_t hashBytes(const char* data, std::size_t size, std::uint64_t seed);
+    static std::uint64_t hashPlacement(EntityID eID, const Placement& p);
+
+    ///eID's modules in sys as one contribution; 0 if it has none
+    std::uint64_t hashModules(EntityID eID, SystemBase& sys);
+
+    ///rehashes everything touched since the last call, and returns the XOR of all module contributions
+    std::uint64_t flush();
+
+    void moduleCreated(SystemBase& sys, EntityID eID) { dirty.push_back(std::make_pair(eID, &sys)); }
+    void moduleModified(SystemBase& sys, EntityID eID) { dirty.push_back(std::make_pair(eID, &sys)); }
+    void moduleDestroyed(SystemBase& sys, EntityID eID);
+
+    MemoryReport memoryReport() const;
+
+    private:
+    std::unordered_map<std::uint64_t, std::uint64_t> contributions;
+    std::vector<std::pair<EntityID, SystemBase*>> dirty;
+    std::uint64_t total = 0;
+    std::vector<char> scratch;
+
+    ///unique among live entities, since no two share a slot; hashes are seeded with the generation as well
+    static std::uint64_t key(EntityID eID, SystemType st) {
+        return (std::uint64_t(eID.slot()) << 32) | std::uint32_t(st);
+    }
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <tuple>
+#include <array>
+#include <utility>
+
+#include "worldbase.h"
+
+///a World whose System set is fixed at compile time
+/// SystemType -> System is a constexpr lookup, and updates/component creation use qualified (non-virtual) calls,
+/// so the hot paths have no vtable hops and no dynamic_casts
+///Entities are still ordinary Entities, so save/load/duplicate work as in any WorldBase, and SavedEntities
+/// can be moved between StaticWorlds and dynamic worlds freely
+///
+///the qualified calls need customUpdate/instantiateTemplate/postCreate overrides to be public; a System that keeps
+/// one protected or private still works, through the usual virtual call for that function
+template <class... Systems>
+class StaticWorld : public WorldBase {
+    static_assert(sizeof...(Systems) > 0, "StaticWorld needs at least one System");
+
+    std::tuple<Systems&...> systems;
+
+    static constexpr std::array<SystemType, sizeof...(Systems)> types = {Systems::Type...};
+
+    template <std::size_t N>
+    static constexpr std::size_t firstIndex(const std::array<SystemType, N>& list, SystemType t) {
+        for (std::size_t i = 0; i < N; i++) if (list[i] == t) return i;
+        return N;
+    }
+
+    static constexpr bool uniqueTypes() {
+        for (std::size_t i = 0; i < types.size(); i++) if (firstIndex(types, types[i]) != i) return false;
+        return true;
+    }
+
+    static_assert(uniqueTypes(), "StaticWorld received system list with Type duplicates");
+
+    public:
+    StaticWorld(Systems&... s)
+        : WorldBase({s...}), systems(s...) {}
+
+    template <SystemType T>
+    static constexpr bool hasSystem() {
+        return firstIndex(types, T) < types.size();
+    }
+
+    template <SystemType T>
+    auto& system() {
+        static_assert(hasSystem<T>(), "StaticWorld doesn't contain a System of this SystemType");
+        return std::get<firstIndex(types, T)>(systems);
+    }
+
+    ///calls Sys::customUpdate directly, skipping System::update's virtual hop (unless Sys::customUpdate isn't public)
+    template <class Sys, class... Args>
+    void updateSystem(Args&&... args) {
+        Sys& s = std::get<Sys&>(systems);
+        if constexpr (requires { s.Sys::customUpdate(std::forward<Args>(args)...); }) {
+            s.Sys::customUpdate(std::forward<Args>(args)...);
+        }
+        else {
+            s.update(std::forward<Args>(args)...);
+        }
+    }
+
+    ///accepts TypedPartialComponents; anything else should go through WorldBase::makeEntity
+    template <class... PCs>
+    EntityID makeEntityStatic(Placement p, const PCs&... pcs) {
+        EntityID ID = makeNewID();
+
+        std::unique_ptr<Entity> e = std::make_unique<Entity>(ID, p);
+        (createStatic(ID, *e, pcs), ...);
+
+        insertEntity(std::move(e), false);
+        postCreateAll<PCs...>(ID, std::index_sequence_for<PCs...>());
+
+        return ID;
+    }
+
+    private:
+    template <class PC>
+    void createStatic(EntityID ID, Entity& e, const PC& pc) {
+        auto& s = system<PC::Type>();
+        typedef std::remove_reference_t<decltype(s)> Sys;
+
+        static_assert(std::is_same<typename Sys::TemplateType, typename PC::TemplateType>::value,
+                      "PartialComponent Template doesn't match the Template of the System registered for its SystemType");
+
+        s.template createModuleStatic<Sys>(ID, pc.getTemplate(), PC::Type);
+        e.addRelatedSystem(&s);
+    }
+
+    ///postCreate once per System, like the dynamic path (which dedupes through Entity::relatedSystems)
+    template <class... PCs, std::size_t... I>
+    void postCreateAll(EntityID ID, std::index_sequence<I...>) {
+        constexpr std::array<SystemType, sizeof...(PCs)> pcTypes = {PCs::Type...};
+        (postCreateIfFirst<PCs::Type>(ID, firstIndex(pcTypes, PCs::Type) == I), ...);
+    }
+
+    template <SystemType T>
+    void postCreateIfFirst(EntityID ID, bool first) {
+        if (!first) return;
+
+        auto& s = system<T>();
+        typedef std::remove_reference_t<decltype(s)> Sys;
+        if constexpr (requires { s.Sys::postCreate(ID); }) s.Sys::postCreate(ID);
+        else static_cast<SystemBase&>(s).postCreate(ID);
+    }
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <bit>
+
+///a dense growable bitset; TagSystem keeps one per tag, indexed by EntityID
+///the set operations are plain loops over 64 bit words, which compilers vectorize at -O2/-O3
+class TagSet {
+    std::vector<std::uint64_t> words;
+    std::size_t setBits;
+
+    static std::size_t wordOf(std::size_t i) { return i >> 6; }
+    static std::uint64_t bitOf(std::size_t i) { return std::uint64_t(1) << (i & 63); }
+
+    void recount() {
+        setBits = 0;
+        for (std::uint64_t w : words) setBits += std::popcount(w);
+    }
+
+    public:
+    TagSet()
+        : setBits(0) {}
+
+    bool test(std::size_t i) const {
+        return wordOf(i) < words.size() && (words[wordOf(i)] & bitOf(i));
+    }
+
+    ///returns false if i was already set
+    bool set(std::size_t i) {
+        if (wordOf(i) >= words.size()) words.resize(wordOf(i) + 1, 0);
+        if (words[wordOf(i)] & bitOf(i)) return false;
+
+        words[wordOf(i)] |= bitOf(i);
+        setBits++;
+        return true;
+    }
+
+    ///returns false if i wasn't set
+    bool reset(std::size_t i) {
+        if (!test(i)) return false;
+
+        words[wordOf(i)] &= ~bitOf(i);
+        setBits--;
+        return true;
+    }
+
+    void clear() {
+        words.clear();
+        setBits = 0;
+    }
+
+    std::size_t count() const { return setBits; }
+    bool empty() const { return setBits == 0; }
+
+    TagSet& operator&= (const TagSet& other) {
+        std::size_t n = std::min(words.size(), other.words.size());
+        words.resize(n);
+        for (std::size_t i = 0; i < n; i++) words[i] &= other.words[i];
+        recount();
+        return *this;
+    }
+
+    TagSet& operator|= (const TagSet& other) {
+        if (other.words.size() > words.size()) words.resize(other.words.size(), 0);
+        for (std::size_t i = 0; i < other.words.size(); i++) words[i] |= other.words[i];
+        recount();
+        return *this;
+    }
+
+    ///this &= ~other
+    TagSet& andNot(const TagSet& other) {
+        std::size_t n = std::min(words.size(), other.words.size());
+        for (std::size_t i = 0; i < n; i++) words[i] &= ~other.words[i];
+        recount();
+        return *this;
+    }
+
+    friend TagSet operator& (TagSet a, const TagSet& b) { return a &= b; }
+    friend TagSet operator| (TagSet a, const TagSet& b) { return a |= b; }
+    friend TagSet andNot(TagSet a, const TagSet& b) { return a.andNot(b); }
+
+    ///out = a & b; reuses out's storage, so a query run every frame doesn't allocate after the first
+    static void intersect(const TagSet& a, const TagSet& b, TagSet& out) {
+        std::size_t n = std::min(a.words.size(), b.words.size());
+        out.words.resize(n);
+        for (std::size_t i = 0; i < n; i++) out.words[i] = a.words[i] & b.words[i];
+        out.recount();
+    }
+
+    ///popcount(this & other), without building the intersection
+    std::size_t countAnd(const TagSet& other) const {
+        std::size_t n = std::min(words.size(), other.words.size());
+        std::size_t out = 0;
+        for (std::size_t i = 0; i < n; i++) out += std::popcount(words[i] & other.words[i]);
+        return out;
+    }
+
+    ///popcount(this & ~other)
+    std::size_t countAndNot(const TagSet& other) const {
+        std::size_t out = 0;
+        for (std::size_t i = 0; i < words.size(); i++) {
+            std::uint64_t mask = i < other.words.size() ? other.words[i] : 0;
+            out += std::popcount(words[i] & ~mask);
+        }
+        return out;
+    }
+
+    ///f(index) for each set bit, ascending; skips empty words, so sparse sets iterate fast
+    template <class F>
+    void forEach(F f) const {
+        for (std::size_t w = 0; w < words.size(); w++) {
+            std::uint64_t bits = words[w];
+            while (bits) {
+                f((w << 6) + std::countr_zero(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    ///drops trailing empty words
+    void shrink() {
+        while (!words.empty() && words.back() == 0) words.pop_back();
+        words.shrink_to_fit();
+    }
+
+    ///every set bit is below this
+    std::size_t extent() const { return words.size() * 64; }
+    std::size_t bytes() const { return words.capacity() * sizeof(std::uint64_t); }
+};
@@ -0,0 +1,183 @@
+#include "task.h"
+
+#include <cmath>
+#include <algorithm>
+
+void NextFrameAwaiter::await_suspend(Task::Handle h) {
+    h.promise().system->scheduleNextFrame(h.promise().taskID);
+}
+
+void WaitAwaiter::await_suspend(Task::Handle h) {
+    h.promise().system->scheduleWait(h.promise().taskID, seconds);
+}
+
+void UntilAwaiter::await_suspend(Task::Handle h) {
+    h.promise().system->scheduleUntil(h.promise().taskID, std::move(predicate));
+}
+
+
+TaskSystem::TaskSystem(double wheelResolution, int wheelSlots)
+    : nextTaskID(1), wheel(wheelSlots), resolution(wheelResolution), now(0.), currentTick(0),
+      running(0), runningCancelled(false) {
+    assert(wheelResolution > 0. && wheelSlots > 0);
+}
+
+TaskSystem::~TaskSystem() {
+    for (auto& t : tasks) t.second.handle.destroy();
+}
+
+void TaskSystem::start(EntityID eID, Task&& t) {
+    assert(t.handle);
+
+    TaskID ID = nextTaskID++;
+    Task::Handle h = t.handle;
+    t.handle = nullptr;
+
+    h.promise().system = this;
+    h.promise().taskID = ID;
+
+    tasks.insert(std::make_pair(ID, TaskInfo{h, eID}));
+    entityTasks[eID].push_back(ID);
+    nextFrameList.push_back(ID);
+}
+
+std::size_t TaskSystem::taskCount(EntityID eID) const {
+    if (!entityTasks.count(eID)) return 0;
+    return entityTasks.at(eID).size();
+}
+
+void TaskSystem::scheduleNextFrame(TaskID taskID) {
+    nextFrameList.push_back(taskID);
+}
+
+void TaskSystem::scheduleWait(TaskID taskID, double seconds) {
+    double deadline = now + seconds;
+    long long tick = std::max(currentTick, (long long) std::floor(deadline / resolution));
+
+    wheel[tick % wheel.size()].push_back(Timer{taskID, deadline});
+}
+
+void TaskSystem::scheduleUntil(TaskID taskID, std::function<bool()>&& predicate) {
+    untilList.push_back(std::make_pair(taskID, std::move(predicate)));
+}
+
+void TaskSystem::update(double deltaTime) {
+    now += deltaTime;
+
+    //a task that throws doesn't stop the pass; every loop finishes and the schedule stays consistent, then the
+    // first exception is rethrown
+    std::exception_ptr exception;
+
+    nextFrameScratch.swap(nextFrameList);
+    for (TaskID ID : nextFrameScratch) resume(ID, exception);
+    nextFrameScratch.clear();
+
+    //visit every slot between the last tick and now, at most one full turn;
+    // timers more than a turn out share slots with nearer ones, so deadlines are checked exactly
+    long long targetTick = (long long) std::floor(now / resolution);
+    long long lastTick = std::min(targetTick, currentTick + (long long) wheel.size() - 1);
+
+    for (long long t = currentTick; t <= lastTick; t++) {
+        std::vector<Timer>& slot = wheel[t % wheel.size()];
+        if (slot.empty()) continue;
+
+        timerScratch.swap(slot);
+        for (Timer& timer : timerScratch) {
+            if (timer.deadline <= now) resume(timer.taskID, exception);
+            else slot.push_back(timer);
+        }
+        timerScratch.clear();
+    }
+    currentTick = targetTick;
+
+    untilScratch.swap(untilList);
+    for (auto& u : untilScratch) {
+        if (!tasks.count(u.first)) continue;
+
+        if (u.second()) resume(u.first, exception);
+        else untilList.push_back(std::move(u));
+    }
+    untilScratch.clear();
+
+    if (exception) std::rethrow_exception(exception);
+}
+
+void TaskSystem::resume(TaskID taskID, std::exception_ptr& firstException) {
+    //cancelled tasks leave stale IDs in the schedule; IDs aren't reused, so they're just skipped
+    auto it = tasks.find(taskID);
+    if (it == tasks.end()) return;
+
+    Task::Handle h = it->second.handle;
+
+    running = taskID;
+    runningCancelled = false;
+    h.resume();
+    running = 0;
+
+    if (h.promise().exception && !firstException) firstException = h.promise().exception;
+    if (runningCancelled || h.done()) finish(taskID);
+}
+
+void TaskSystem::finish(TaskID taskID) {
+    auto it = tasks.find(taskID);
+    if (it == tasks.end()) return;
+
+    auto owner = entityTasks.find(it->second.owner);
+    if (owner != entityTasks.end()) {
+        std::vector<TaskID>& list = owner->second;
+        list.erase(std::remove(list.begin(), list.end(), taskID), list.end());
+        if (list.empty()) entityTasks.erase(owner);
+    }
+
+    it->second.handle.destroy();
+    tasks.erase(it);
+}
+
+void TaskSystem::destroyEntityModules(EntityID eID) {
+    auto owner = entityTasks.find(eID);
+    if (owner == entityTasks.end()) return;
+
+    std::vector<TaskID> list = std::move(owner->second);
+    entityTasks.erase(owner);
+
+    for (TaskID ID : list) {
+        if (ID == running) {
+            runningCancelled = true;
+            continue;
+        }
+
+        auto it = tasks.find(ID);
+        it->second.handle.destroy();
+        tasks.erase(it);
+    }
+}
+
+MemoryReport TaskSystem::memoryReport() const {
+    MemoryReport out("TaskSystem");
+
+    std::size_t entityLists = 0;
+    for (auto& e : entityTasks) entityLists += vectorBytes(e.second);
+
+    std::size_t wheelBytes = vectorBytes(wheel);
+    for (auto& slot : wheel) wheelBytes += vectorBytes(slot);
+
+    std::size_t untilBytes = vectorBytes(untilList) + vectorBytes(untilScratch);
+
+    out.add("tasks", hashContainerBytes(tasks));
+    out.add("entityTasks", hashContainerBytes(entityTasks) + entityLists);
+    out.add("nextFrame", vectorBytes(nextFrameList) + vectorBytes(nextFrameScratch));
+    out.add("timer wheel", wheelBytes + vectorBytes(timerScratch));
+    out.add("until", untilBytes);
+    return out;
+}
+
+void TaskSystem::compact() {
+    shrinkHashContainer(tasks);
+    shrinkHashContainer(entityTasks);
+    shrinkVector(nextFrameList);
+    shrinkVector(nextFrameScratch);
+    for (auto& slot : wheel) shrinkVector(slot);
+    shrinkVector(timerScratch);
+    shrinkVector(untilList);
+    shrinkVector(untilScratch);
+}
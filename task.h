@@ -0,0 +1,151 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include "component.h"
+
+class TaskSystem;
+
+///never reused, so a stale ID in a schedule can't resume a newer task
+typedef std::uint64_t TaskID;
+
+///a multi-frame behaviour bound to an Entity, written as a C++20 coroutine, ex:
+///  Task blink(Light& l) { while (true) { l.on = !l.on; co_await wait(0.5); } }
+///  world.startTask(eid, blink(light));
+///tasks first run on the next WorldBase::update, and are cancelled (destroyed at their current suspension point)
+/// when their Entity is destroyed; a task that destroys its own Entity runs on until its next co_await
+class Task {
+    public:
+    struct promise_type {
+        TaskSystem* system = nullptr;
+        TaskID taskID = 0;
+        std::exception_ptr exception;
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+    typedef std::coroutine_handle<promise_type> Handle;
+
+    Task(Task&& other) noexcept
+        : handle(other.handle) { other.handle = nullptr; }
+    Task(const Task&) = delete;
+    ~Task() { if (handle) handle.destroy(); }
+
+    private:
+    explicit Task(Handle h)
+        : handle(h) {}
+
+    Handle handle;
+
+    friend class TaskSystem;
+};
+
+
+///awaitables; only valid inside a Task
+
+struct NextFrameAwaiter {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(Task::Handle h);
+    void await_resume() const noexcept {}
+};
+
+struct WaitAwaiter {
+    double seconds;
+
+    bool await_ready() const noexcept { return seconds <= 0.; }
+    void await_suspend(Task::Handle h);
+    void await_resume() const noexcept {}
+};
+
+///the predicate is polled once per frame, so only tasks waiting on until() have a per-frame cost
+struct UntilAwaiter {
+    std::function<bool()> predicate;
+
+    bool await_ready() const { return predicate(); }
+    void await_suspend(Task::Handle h);
+    void await_resume() const noexcept {}
+};
+
+inline NextFrameAwaiter nextFrame() { return NextFrameAwaiter(); }
+inline WaitAwaiter wait(double seconds) { return WaitAwaiter{seconds}; }
+inline UntilAwaiter until(std::function<bool()> predicate) { return UntilAwaiter{std::move(predicate)}; }
+
+
+///owns and schedules Tasks; timed waits live in a hashed timer wheel, so a suspended task costs nothing
+/// until its slot comes up
+///it's a SystemBase so an Entity's tasks get cancelled through the usual destroyEntityModules path
+class TaskSystem : public SystemBase {
+    public:
+    TaskSystem(double wheelResolution = 1./60., int wheelSlots = 256);
+    ~TaskSystem();
+
+    TaskSystem(const TaskSystem&) = delete;
+    TaskSystem& operator= (const TaskSystem&) = delete;
+
+    ///prefer WorldBase::startTask, which also ties the task to the Entity's lifetime
+    void start(EntityID eID, Task&& t);
+
+    ///resumes every task that's due; if any threw, rethrows the first one's exception afterwards
+    void update(double deltaTime);
+
+    std::size_t taskCount() const { return tasks.size(); }
+    std::size_t taskCount(EntityID eID) const;
+
+    void destroyEntityModules(EntityID eID);
+    ///cancels eID's tasks
+    bool removeModule(EntityID eID) { destroyEntityModules(eID); return true; }
+    bool hasModules(EntityID eID) const { return taskCount(eID) > 0; }
+    ///coroutine state can't be saved; tasks need to be restarted after loading
+    std::vector<std::shared_ptr<IPartialComponent>> recreatePartialComponents(EntityID eid) { return {}; }
+    SystemType getType() const { return SystemType::Tasks; }
+    MemoryReport memoryReport() const;
+    void compact();
+
+    ///used by the awaitables
+    void scheduleNextFrame(TaskID taskID);
+    void scheduleWait(TaskID taskID, double seconds);
+    void scheduleUntil(TaskID taskID, std::function<bool()>&& predicate);
+
+    private:
+    struct TaskInfo {
+        Task::Handle handle;
+        EntityID owner;
+    };
+
+    struct Timer {
+        TaskID taskID;
+        double deadline;
+    };
+
+    std::unordered_map<TaskID, TaskInfo> tasks;
+    std::unordered_map<EntityID, std::vector<TaskID>> entityTasks;
+    TaskID nextTaskID;
+
+    std::vector<TaskID> nextFrameList;
+    std::vector<TaskID> nextFrameScratch;
+
+    std::vector<std::vector<Timer>> wheel;
+    std::vector<Timer> timerScratch;
+    double resolution;
+    double now;
+    long long currentTick;
+
+    std::vector<std::pair<TaskID, std::function<bool()>>> untilList;
+    std::vector<std::pair<TaskID, std::function<bool()>>> untilScratch;
+
+    ///the task currently being resumed (0 if none); cancelling it is deferred until it suspends
+    TaskID running;
+    bool runningCancelled;
+
+    ///keeps the first exception a task throws, so update can finish its pass before rethrowing it
+    void resume(TaskID taskID, std::exception_ptr& firstException);
+    void finish(TaskID taskID);
+};
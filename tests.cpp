@@ -0,0 +1,1355 @@
+#include "examplegame.h"
+#include "staticworld.h"
+#include "broadphase.h"
+#include "navsystem.h"
+#include <iostream>
+#include <filesystem>
+#include <thread>
+
+///checks observable behavior of the World's features, on the example game's Systems
+///built by make.sh as testProgram; prints every failed check, and exits nonzero if there were any
+
+static int failures = 0;
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+
+static void check(bool ok, const char* what, int line) {
+	if (ok) return;
+	std::cout<<"tests.cpp:"<<line<<": failed: "<<what<<std::endl;
+	failures++;
+}
+
+static std::size_t containerBytes(const MemoryReport& r, const std::string& name) {
+	for (auto& c : r.containers) if (c.first == name) return c.second;
+	return 0;
+}
+
+
+//deleted entities' slots are reused at the next generation, so a World churning through many segments' worth of
+// entities only keeps the most it had alive at once, and old IDs stay dead
+static void testEntityChurn() {
+	ExampleGameWorld world;
+	const int perRound = 1000;
+
+	std::size_t tableBytes = 0;
+	std::size_t worldBytes = 0;
+	EntityID first = -1;
+
+	//20k spawns, about 5 segments' worth
+	for (int round = 0; round < 20; round++) {
+		std::vector<EntityID> spawned;
+		for (int i = 0; i < perRound; i++) spawned.push_back(world.makeEntity(Placement(), new HealthPC(HealthValue(10.))));
+		if (round == 0) first = spawned[0];
+
+		for (EntityID eid : spawned) CHECK(eid.slot() < perRound + IDAllocator::BlockSize);
+		for (EntityID eid : spawned) world.deleteEntity(eid);
+		for (EntityID eid : spawned) CHECK(!world.hasEntity(eid));
+		world.update(1. / 60.);
+
+		MemoryReport r = world.memoryReport();
+		if (round == 1) {
+			tableBytes = containerBytes(r, "entities");
+			worldBytes = r.total();
+		}
+		else if (round > 1) {
+			CHECK(containerBytes(r, "entities") == tableBytes);
+			CHECK(r.total() == worldBytes);
+		}
+	}
+
+	//the first entity's slot has been reused many times since; its ID doesn't find the current occupant
+	EntityID reuser = world.makeEntity(Placement(), new HealthPC(HealthValue(10.)));
+	CHECK(!world.hasEntity(first));
+	CHECK(reuser.generation() > 0);
+
+	//loading an entity claims its slot, even if that slot was waiting to be reused
+	std::vector<SavedEntity> saved = world.saveEntities({reuser});
+	world.deleteEntity(reuser);
+	EntityID loaded = world.loadEntity(saved[0]);
+	CHECK(loaded == reuser);
+
+	std::vector<EntityID> more;
+	for (int i = 0; i < perRound; i++) more.push_back(world.makeEntity(Placement(), new HealthPC(HealthValue(10.))));
+	for (EntityID eid : more) CHECK(eid.slot() != loaded.slot());
+	CHECK(world.hasEntity(loaded));
+}
+
+//IDs from several threads at once are unique, and claiming a slot past every block moves the bound past it;
+// a thread's cache of per-thread blocks doesn't keep entries for destroyed allocators
+static void testIDThreads() {
+	IDAllocator ids;
+	const int perThread = 1000;
+
+	std::vector<std::vector<EntityID>> got(4);
+	std::vector<std::thread> threads;
+	for (auto& g : got) threads.emplace_back([&g, &ids] { for (int i = 0; i < perThread; i++) g.push_back(ids.allocate()); });
+	for (auto& t : threads) t.join();
+
+	std::unordered_set<std::int64_t> unique;
+	for (auto& g : got) for (EntityID eid : g) unique.insert(eid.ID);
+	CHECK(unique.size() == 4 * perThread);
+	CHECK(ids.idle());
+
+	std::uint32_t bound = ids.bound();
+	ids.claim(EntityID(bound + 10));
+	CHECK(ids.bound() == bound + 11);
+
+	for (int i = 0; i < 100; i++) {
+		PerThread<int> scratch;
+		scratch.local() = i;
+	}
+	CHECK(PerThread<int>::cachedOnThisThread() <= 1);
+}
+
+
+class TagWorld : public WorldBase {
+	public:
+	TagSystem<SystemType::Health> visible;
+	TagSystem<SystemType::Buffs> team;
+
+	TagWorld()
+	 : WorldBase({visible, team}), visible(getIDToEntityFunc()), team(getIDToEntityFunc()) {}
+
+	void customUpdate(double) {}
+};
+
+//tags are bits by slot; set operations go through tags() and back to EntityIDs through idAt, and a reused slot
+// doesn't carry its last entity's tags
+static void testTags() {
+	TagWorld world;
+	std::vector<EntityID> eids;
+	for (int i = 0; i < 200; i++) {
+		std::vector<std::shared_ptr<IPartialComponent>> pcs;
+		if (i % 2 == 0) pcs.push_back(std::make_shared<TypedEmptyPC<SystemType::Health>>());
+		if (i % 3 == 0) pcs.push_back(std::make_shared<TypedEmptyPC<SystemType::Buffs>>());
+		eids.push_back(world.makeEntity(pcs));
+	}
+
+	CHECK(world.visible.count() == 100);
+	CHECK(world.team.count() == 67);
+	CHECK(world.visible.tags().countAnd(world.team.tags()) == 34);
+
+	std::size_t both = 0;
+	(world.visible.tags() & world.team.tags()).forEach([&] (std::size_t slot) {
+		EntityID eid = world.visible.idAt(slot);
+		CHECK(world.visible.has(eid) && world.team.has(eid));
+		both++;
+	});
+	CHECK(both == 34);
+
+	world.removeComponent(eids[6], SystemType::Health);
+	CHECK(!world.visible.has(eids[6]));
+	CHECK(world.team.has(eids[6]));
+
+	//make untagged entities until one lands in a deleted tagged entity's slot
+	world.deleteEntity(eids[0]);
+	std::vector<std::shared_ptr<IPartialComponent>> untagged;
+	EntityID reuser = world.makeEntity(untagged);
+	for (int i = 0; i < 2 * IDAllocator::BlockSize && reuser.slot() != eids[0].slot(); i++) reuser = world.makeEntity(untagged);
+	CHECK(reuser.slot() == eids[0].slot() && !(reuser == eids[0]));
+	CHECK(!world.visible.has(eids[0]));
+	CHECK(!world.visible.has(reuser));
+	CHECK(!world.team.has(reuser));
+
+	std::size_t visited = 0;
+	world.visible.forEach([&] (EntityID eid) {
+		CHECK(world.hasEntity(eid));
+		visited++;
+	});
+	CHECK(visited == 98);
+	CHECK(world.visible.count() == 98);
+}
+
+
+//moves its one entity 1 along x and a quarter turn about z per step
+class StepWorld : public WorldBase {
+	public:
+	EntityID mover;
+	int steps = 0;
+
+	StepWorld()
+	 : WorldBase({}), mover(makeEntity(std::vector<std::shared_ptr<IPartialComponent>>())) {}
+
+	void customUpdate(double) {
+		Placement& p = getEntity(mover).pos;
+		p.pos.x += 1.;
+		p.dir = Quaternion(Vec3(0, 0, 1), M_PI / 2) * p.dir;
+		steps++;
+	}
+};
+
+static bool near(double a, double b) { return std::abs(a - b) < 1e-9; }
+
+static bool near(const Quaternion& a, const Quaternion& b) {
+	float fa[4], fb[4];
+	a.toFloats(fa);
+	b.toFloats(fb);
+	for (int i = 0; i < 4; i++) if (std::abs(fa[i] - fb[i]) > 1e-6f) return false;
+	return true;
+}
+
+//advance runs whole steps up to the cap, Drop discards the rest and Carry keeps it (with alpha clamped to the latest
+// step), and interpolation blends the last step's Placements
+static void testFixedStep() {
+	StepWorld drop;
+	drop.setFixedStep(0.1, 4, CatchUpPolicy::Drop);
+	CHECK(drop.advance(0.05) == 0);
+	CHECK(near(drop.interpolationAlpha(), 0.5));
+	CHECK(drop.advance(0.06) == 1);
+	CHECK(near(drop.interpolationAlpha(), 0.1));
+	CHECK(drop.advance(1.) == 4);
+	CHECK(near(drop.interpolationAlpha(), 0.1));
+	CHECK(drop.advance(0.) == 0);
+	CHECK(drop.steps == 5);
+
+	StepWorld carry;
+	carry.setFixedStep(0.1, 4, CatchUpPolicy::Carry);
+	CHECK(carry.advance(1.) == 4);
+	CHECK(carry.interpolationAlpha() == 1.);
+	CHECK(carry.advance(0.) == 4);
+	CHECK(carry.advance(0.) == 0);
+	CHECK(carry.steps == 8);
+
+	//halfway through step 5: x 4 -> 5, and an eighth turn into the step's quarter turn
+	std::vector<std::pair<EntityID, Placement>> blended;
+	drop.interpolatePlacements(blended, 0.5);
+	CHECK(blended.size() == 1 && blended[0].first == drop.mover);
+	CHECK(near(blended[0].second.pos.x, 4.5));
+	Quaternion before = drop.getEntity(drop.mover).getPrevPos().dir;
+	CHECK(near(blended[0].second.dir, Quaternion(Vec3(0, 0, 1), M_PI / 4) * before));
+	CHECK(near(Quaternion::nlerp(before, drop.getEntity(drop.mover).pos.dir, 0.5), blended[0].second.dir));
+
+	drop.interpolatePlacements(blended, true);
+	CHECK(near(blended[0].second.pos.x, 4.1));
+	CHECK(near(blended[0].second.dir, Quaternion::slerp(before, drop.getEntity(drop.mover).pos.dir, 0.1)));
+}
+
+struct TestEvent {
+	EntityID eID;
+	int thread;
+	int seq;
+};
+
+//producers on several threads all land in one published batch, which drainSortedByEntity hands over once, grouped
+// by entity with each thread's events still in emission order
+static void testEventBus() {
+	EventBus bus;
+	EventChannel<TestEvent>& channel = bus.channel<TestEvent>();
+	const int perThread = 1000;
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++) {
+		threads.emplace_back([&channel, t] { for (int i = 0; i < perThread; i++) channel.emit(TestEvent{EntityID(i % 50), t, i}); });
+	}
+	for (auto& t : threads) t.join();
+
+	CHECK(channel.events().empty());
+	bus.publish();
+	CHECK(channel.events().size() == 4 * perThread);
+
+	std::size_t drained = 0;
+	bool ordered = true;
+	channel.drainSortedByEntity([&] (const std::vector<TestEvent>& events) {
+		drained += events.size();
+		std::vector<int> lastSeq(4, -1);
+		for (std::size_t i = 0; i < events.size(); i++) {
+			if (i > 0 && events[i].eID < events[i - 1].eID) ordered = false;
+			if (i > 0 && events[i - 1].eID < events[i].eID) lastSeq.assign(4, -1);
+			if (events[i].seq <= lastSeq[events[i].thread]) ordered = false;
+			lastSeq[events[i].thread] = events[i].seq;
+		}
+	});
+	CHECK(drained == 4 * perThread);
+	CHECK(ordered);
+	CHECK(channel.events().empty());
+
+	//the threads' buffers were emptied by the merge, so the next batch only has what's emitted since
+	channel.emplace(TestEvent{EntityID(7), 0, 0});
+	bus.publish();
+	CHECK(channel.events().size() == 1);
+	bus.publish();
+	CHECK(channel.events().empty());
+}
+
+struct Counter {
+	int ticks;
+};
+typedef TypedPartialComponent<Counter, SystemType::Health> CounterPC;
+
+//customUpdate isn't public, so StaticWorld::updateSystem has to fall back to the virtual call
+class CounterSystem : public SimpleSystem<Counter, SystemType::Health> {
+	public:
+	CounterSystem(std::function<Entity*(EntityID)> idToEntity)
+	 : SimpleSystem(idToEntity) {}
+
+	int postCreates = 0;
+	void postCreate(EntityID eID) { postCreates++; }
+
+	protected:
+	void customUpdate() {
+		applyFunctionToModules([] (EntityID, Entity&, Counter& c) { c.ticks++; });
+	}
+};
+
+struct Elapsed {
+	double seconds;
+};
+typedef TypedPartialComponent<Elapsed, SystemType::Buffs> ElapsedPC;
+
+class ElapsedSystem : public SimpleMultiSystem<Elapsed, SystemType::Buffs, double> {
+	public:
+	ElapsedSystem(std::function<Entity*(EntityID)> idToEntity)
+	 : SimpleMultiSystem(idToEntity) {}
+
+	void customUpdate(double deltaTime) {
+		applyFunctionToModulesWithIDs([&] (EntityID, ModuleID, Entity&, Elapsed& e) { e.seconds += deltaTime; });
+	}
+};
+
+class StaticTestWorld : public StaticWorld<CounterSystem, ElapsedSystem> {
+	public:
+	CounterSystem counters;
+	ElapsedSystem elapsed;
+
+	StaticTestWorld()
+	 : StaticWorld(counters, elapsed), counters(getIDToEntityFunc()), elapsed(getIDToEntityFunc()) {}
+
+	void customUpdate(double deltaTime) {
+		updateSystem<CounterSystem>();
+		updateSystem<ElapsedSystem>(deltaTime);
+	}
+};
+
+class DynamicTestWorld : public WorldBase {
+	public:
+	CounterSystem counters;
+	ElapsedSystem elapsed;
+
+	DynamicTestWorld()
+	 : WorldBase({counters, elapsed}), counters(getIDToEntityFunc()), elapsed(getIDToEntityFunc()) {}
+
+	void customUpdate(double deltaTime) {
+		counters.update();
+		elapsed.update(deltaTime);
+	}
+};
+
+static void testStaticWorld() {
+	StaticTestWorld world;
+	CHECK(&world.system<SystemType::Health>() == &world.counters);
+	CHECK(&world.system<SystemType::Buffs>() == &world.elapsed);
+	CHECK(!StaticTestWorld::hasSystem<SystemType::Nav>());
+
+	EntityID eid = world.makeEntityStatic(Placement(), CounterPC(Counter{0}), ElapsedPC(Elapsed{0.}), ElapsedPC(Elapsed{1.}));
+	CHECK(world.counters.postCreates == 1);
+	CHECK(world.elapsed.moduleCount() == 2);
+
+	for (int i = 0; i < 3; i++) world.update(0.5);
+	CHECK(world.getEntity(eid).get<CounterSystem>().ticks == 3);
+	double total = 0.;
+	world.elapsed.applyFunctionToModulesWithIDs([&] (EntityID, ModuleID, Entity&, Elapsed& e) { total += e.seconds; });
+	CHECK(total == 4.);
+
+	//saved entities move to a dynamic world with the same System
+	DynamicTestWorld dynamic;
+	EntityID loaded = dynamic.loadEntity(world.saveEntities({eid})[0]);
+	dynamic.update(1.);
+	CHECK(dynamic.getEntity(loaded).get<CounterSystem>().ticks == 4);
+	CHECK(dynamic.counters.postCreates == 1);
+	CHECK(dynamic.elapsed.moduleCount() == 2);
+}
+
+static void testPrefabs() {
+	ExampleGameWorld world;
+	Prefab prefab = world.compilePrefab({std::make_shared<HealthPC>(HealthValue(50.)),
+	                                     std::make_shared<BuffPC>(BuffValue{1., 10.})});
+	CHECK(prefab.componentCount() == 2);
+
+	EntityID one = world.instantiate(prefab, Placement(Vec3(1, 2, 3)));
+	std::vector<EntityID> many = world.instantiate(prefab, std::vector<Placement>(10, Placement()));
+	CHECK(many.size() == 10);
+	CHECK(world.getEntity(one).pos.pos.y == 2.);
+	CHECK(world.healthSystem.get(one).curHealth == 50.);
+	CHECK(world.buffSystem.moduleCount() == 11);
+
+	bool threw = false;
+	try { world.compilePrefab({std::make_shared<ColliderPC>(Collider{Vec3(1, 1, 1), Vec3()})}); }
+	catch (std::invalid_argument&) { threw = true; }
+	CHECK(threw);
+}
+
+//a Template holding a vector, which counts its own copies
+struct Loadout {
+	static int copies;
+
+	std::vector<int> items;
+	std::string name;
+
+	Loadout(std::vector<int>&& i, std::string n)
+	 : items(std::move(i)), name(std::move(n)) {}
+	Loadout(const Loadout& other)
+	 : items(other.items), name(other.name) { copies++; }
+	Loadout(Loadout&&) = default;
+	Loadout& operator= (const Loadout& other) {
+		items = other.items;
+		name = other.name;
+		copies++;
+		return *this;
+	}
+	Loadout& operator= (Loadout&&) = default;
+};
+int Loadout::copies = 0;
+
+class LoadoutSystem : public SimpleSystem<Loadout, SystemType::Health> {
+	public:
+	LoadoutSystem(std::function<Entity*(EntityID)> idToEntity)
+	 : SimpleSystem(idToEntity) {}
+
+	void customUpdate() {}
+};
+
+class LoadoutWorld : public WorldBase {
+	public:
+	LoadoutSystem loadouts;
+
+	LoadoutWorld()
+	 : WorldBase({loadouts}), loadouts(getIDToEntityFunc()) {}
+
+	void customUpdate(double) {}
+};
+
+//emplace builds the Template from its args and moves it into the Instance: no Template copies, and the vector's
+// buffer is the one passed in; the PartialComponent path copies
+static void testEmplace() {
+	LoadoutWorld world;
+
+	Loadout::copies = 0;
+	std::vector<int> items(1000, 7);
+	const int* buffer = items.data();
+	EntityID eid = world.makeEntity(Placement(), emplace<LoadoutSystem>(std::move(items), std::string("scout")));
+
+	Loadout& made = world.getEntity(eid).get<LoadoutSystem>();
+	CHECK(Loadout::copies == 0);
+	CHECK(made.items.data() == buffer && made.items.size() == 1000);
+	CHECK(made.name == "scout");
+	CHECK(world.loadouts.hasModules(eid));
+
+	world.makeEntity(Placement(), new TypedPartialComponent<Loadout, SystemType::Health>(Loadout(std::vector<int>(10, 1), "heavy")));
+	CHECK(Loadout::copies > 0);
+}
+
+static Task countFrames(int& frames) {
+	while (true) {
+		frames++;
+		co_await nextFrame();
+	}
+}
+
+static Task flagAfter(double seconds, bool& done) {
+	co_await wait(seconds);
+	done = true;
+}
+
+static Task throwNextFrame() {
+	co_await nextFrame();
+	throw std::runtime_error("task failed");
+}
+
+static void testTasks() {
+	ExampleGameWorld world;
+	EntityID eid = world.makeEntity(Placement(), new HealthPC(HealthValue(10.)));
+
+	int frames = 0;
+	bool done = false;
+	world.startTask(eid, countFrames(frames));
+	world.startTask(eid, flagAfter(0.5, done));
+	CHECK(frames == 0);
+
+	for (int i = 0; i < 3; i++) world.update(0.1);
+	CHECK(frames == 3);
+	CHECK(!done);
+	for (int i = 0; i < 3; i++) world.update(0.1);
+	CHECK(done);
+
+	//an entity's tasks are cancelled with it
+	world.deleteEntity(eid);
+	world.update(0.1);
+	CHECK(frames == 6);
+
+	//a throwing task doesn't stop the rest of the pass, and nothing runs twice afterwards
+	EntityID other = world.makeEntity(Placement(), new HealthPC(HealthValue(10.)));
+	frames = 0;
+	done = false;
+	world.startTask(other, throwNextFrame());
+	world.startTask(other, countFrames(frames));
+	world.startTask(other, flagAfter(0.05, done));
+	world.update(0.1);
+	CHECK(frames == 1);
+
+	bool threw = false;
+	try { world.getTaskSystem().update(0.1); }
+	catch (std::runtime_error&) { threw = true; }
+	CHECK(threw);
+	CHECK(frames == 2);
+	CHECK(done);
+	CHECK(world.getTaskSystem().taskCount(other) == 1);
+
+	world.getTaskSystem().update(0.1);
+	CHECK(frames == 3);
+}
+
+//after a spawn spike, compaction gives the spike's memory back, in budgeted steps or all at once, and a repack keeps
+// every surviving module (and the Entity module cache) intact
+static void testCompaction() {
+	ExampleGameWorld world;
+	std::vector<EntityID> eids;
+	for (int i = 0; i < 5000; i++) eids.push_back(world.makeEntity(Placement(), new HealthPC(HealthValue(10. + i))));
+	world.update(0.1);
+	for (int i = 50; i < 5000; i++) world.deleteEntity(eids[i]);
+	eids.erase(eids.begin() + 50, eids.end());
+	world.update(0.1);
+
+	std::size_t spiked = world.memoryReport().total();
+
+	//a zero budget still takes one step per call
+	int calls = 1;
+	while (!world.compact(0.)) calls++;
+	CHECK(calls > 3);
+	std::size_t compacted = world.memoryReport().total();
+	CHECK(compacted < spiked);
+
+	int again = 1;
+	while (!world.compact(0.)) again++;
+	CHECK(again == calls);
+	CHECK(world.memoryReport().total() == compacted);
+
+	//the same through update, with a budget
+	ExampleGameWorld budgeted;
+	std::vector<EntityID> spike;
+	for (int i = 0; i < 5000; i++) spike.push_back(budgeted.makeEntity(Placement(), new HealthPC(HealthValue(10.))));
+	budgeted.update(0.1);
+	for (EntityID eid : spike) budgeted.deleteEntity(eid);
+	budgeted.update(0.1);
+	std::size_t before = budgeted.memoryReport().total();
+	budgeted.setCompactionBudget(1.);
+	budgeted.update(0.1);
+	CHECK(budgeted.memoryReport().total() < before);
+
+	world.healthSystem.setRepackOnCompact(true);
+	CHECK(world.compact(1.));
+	for (int i = 0; i < 50; i++) {
+		Entity& e = world.getEntity(eids[i]);
+		CHECK(e.get<HealthSystem>().curHealth == 10. + i);
+		CHECK(&e.get<HealthSystem>() == world.healthSystem.modulePtr(eids[i]));
+	}
+	CHECK(world.healthSystem.moduleCount() == 50);
+}
+
+static std::vector<EntityID> spawnBuffed(ExampleGameWorld& world, int n) {
+	std::vector<EntityID> out;
+	for (int i = 0; i < n; i++) {
+		out.push_back(world.makeEntity(Placement(Vec3(i, 0, 0)), new HealthPC(HealthValue(100.)),
+		                               new BuffPC(BuffValue{1. + i, 0.5 + i * 0.1})));
+	}
+	return out;
+}
+
+static void testJournal() {
+	std::string path = (std::filesystem::temp_directory_path() / "wedge_tests_journal").string();
+	std::filesystem::remove(path + ".journal");
+	std::filesystem::remove(path + ".checkpoint");
+
+	std::uint64_t expected;
+	std::size_t expectedCount;
+	{
+		ExampleGameWorld world;
+		Journal journal(path);
+		world.setJournal(&journal);
+
+		std::vector<EntityID> eids = spawnBuffed(world, 20);
+		for (int i = 0; i < 10; i++) world.update(0.1);
+		journal.checkpoint(world);
+
+		//after the checkpoint: moves, deletions, removed components, damage
+		//moved between updates, so it has to be journaled by hand
+		world.getEntity(eids[3]).pos = Placement(Vec3(0, 5, 0));
+		journal.entityMoved(eids[3], world.getEntity(eids[3]).pos);
+		world.deleteEntity(eids[4]);
+		world.removeComponent(eids[5], SystemType::Health);
+		spawnBuffed(world, 5);
+		for (int i = 0; i < 10; i++) world.update(0.1);
+
+		expected = world.fullStateHash();
+		expectedCount = world.entityCount();
+	}
+
+	ExampleGameWorld recovered;
+	CHECK(Journal::recover(path, recovered) == 10);
+	CHECK(recovered.entityCount() == expectedCount);
+	CHECK(recovered.fullStateHash() == expected);
+
+	std::filesystem::remove(path + ".journal");
+	std::filesystem::remove(path + ".checkpoint");
+}
+
+//one line per component, so saves can be compared whatever order their components are in
+static std::vector<std::string> describe(const SavedEntity& saved) {
+	std::vector<std::string> out;
+	for (auto& c : saved.components) {
+		if (auto* h = dynamic_cast<const PartialComponent<HealthValue>*>(c.get())) {
+			out.push_back("health " + std::to_string(h->getTemplate().maxHealth) + " " + std::to_string(h->getTemplate().curHealth));
+		}
+		else if (auto* b = dynamic_cast<const PartialComponent<BuffValue>*>(c.get())) {
+			out.push_back("buff " + std::to_string(b->getTemplate().damagePerSecond) + " " + std::to_string(b->getTemplate().remaining));
+		}
+		else out.push_back("unknown");
+	}
+	std::sort(out.begin(), out.end());
+	return out;
+}
+
+static bool sameSaves(std::vector<SavedEntity> a, std::vector<SavedEntity> b) {
+	auto byID = [] (const SavedEntity& x, const SavedEntity& y) { return x.ID < y.ID; };
+	std::sort(a.begin(), a.end(), byID);
+	std::sort(b.begin(), b.end(), byID);
+
+	if (a.size() != b.size()) return false;
+	for (std::size_t i = 0; i < a.size(); i++) {
+		if (!(a[i].ID == b[i].ID) || std::memcmp(&a[i].pos, &b[i].pos, sizeof(Placement)) != 0) return false;
+		if (describe(a[i]) != describe(b[i])) return false;
+	}
+	return true;
+}
+
+//snapshots turn into the same SavedEntities as saveEntities, on the update thread or a save's worker, and still do
+// once the World that took them is gone
+static void testSnapshotSave() {
+	std::vector<SavedEntity> expected;
+	WorldSnapshot orphan;
+	{
+		ExampleGameWorld world;
+		std::vector<EntityID> eids = spawnBuffed(world, 30);
+		eids.push_back(world.makeEntity(Placement(Vec3(0, 1, 0)), new HealthPC(HealthValue(7.))));
+		for (int i = 0; i < 3; i++) world.update(0.1);
+
+		expected = world.saveEntities(eids);
+		WorldSnapshot snapshot = world.snapshot();
+		CHECK(snapshot.placements.size() == eids.size());
+		CHECK(snapshot.moduleCount() == world.healthSystem.moduleCount() + world.buffSystem.moduleCount());
+		CHECK(sameSaves(snapshot.toSavedEntities(), expected));
+
+		std::vector<SavedEntity> written;
+		std::unique_ptr<AsyncSave> save = world.saveAsync([&] (std::vector<SavedEntity>&& saved) { written = std::move(saved); });
+		save->wait();
+		CHECK(save->done() && save->progress() == 1.);
+		CHECK(sameSaves(written, expected));
+
+		//a failing writer's exception comes out of wait
+		save = world.saveAsync([] (std::vector<SavedEntity>&&) { throw std::runtime_error("disk full"); });
+		bool threw = false;
+		try { save->wait(); }
+		catch (std::runtime_error&) { threw = true; }
+		CHECK(threw);
+
+		orphan = world.snapshot();
+	}
+	CHECK(sameSaves(orphan.toSavedEntities(), expected));
+
+	//progress counts modules converted, and holds short of 1 while the writer runs
+	std::size_t modules = orphan.moduleCount();
+	std::atomic<bool> writing(false), release(false);
+	std::vector<SavedEntity> written;
+	AsyncSave save(std::move(orphan), [&] (std::vector<SavedEntity>&& saved) {
+		written = std::move(saved);
+		writing = true;
+		while (!release) std::this_thread::yield();
+	});
+	while (!writing) std::this_thread::yield();
+	CHECK(!save.done());
+	CHECK(save.progress() == double(modules) / double(modules + 1));
+	release = true;
+	save.wait();
+	CHECK(save.progress() == 1.);
+	CHECK(sameSaves(written, expected));
+}
+
+class CountingHealth : public SimpleSystem<HealthValue, SystemType::Health> {
+	public:
+	int postCreates = 0;
+	int instantiated = 0;
+
+	CountingHealth(std::function<Entity*(EntityID)> idToEntity)
+	 : SimpleSystem(idToEntity) {}
+
+	void customUpdate() {}
+	void postCreate(EntityID) { postCreates++; }
+
+	std::unique_ptr<HealthValue> instantiateTemplate(const HealthValue& t) {
+		instantiated++;
+		return SimpleSystem::instantiateTemplate(t);
+	}
+};
+
+class CountingBuffs : public SimpleMultiSystem<BuffValue, SystemType::Buffs, double> {
+	public:
+	int postCreates = 0;
+
+	CountingBuffs(std::function<Entity*(EntityID)> idToEntity)
+	 : SimpleMultiSystem(idToEntity) {}
+
+	void customUpdate(double) {}
+	void postCreate(EntityID) { postCreates++; }
+};
+
+///the example game's modules, in Systems of the same Template/Instance types
+class LoadWorld : public WorldBase {
+	public:
+	CountingHealth health;
+	CountingBuffs buffs;
+
+	LoadWorld()
+	 : WorldBase({health, buffs}), health(getIDToEntityFunc()), buffs(getIDToEntityFunc()) {}
+
+	void customUpdate(double) {}
+};
+
+///a Health System with its own Instance type, so snapshot columns of HealthValue can't be bulk-inserted into it
+struct HealthMirror {
+	double hp;
+};
+
+class MirrorSystem : public System<HealthValue, HealthMirror, SystemType::Health> {
+	public:
+	MirrorSystem(std::function<Entity*(EntityID)> idToEntity)
+	 : System(idToEntity) {}
+
+	void customUpdate() {}
+
+	std::unique_ptr<HealthMirror> instantiateTemplate(const HealthValue& t) {
+		return std::make_unique<HealthMirror>(HealthMirror{t.curHealth});
+	}
+
+	std::shared_ptr<PartialComponent<HealthValue>> _recreatePartialComponent(const HealthMirror& i, SystemType st) const {
+		return std::make_shared<HealthPC>(HealthValue(i.hp));
+	}
+};
+
+class MirrorWorld : public WorldBase {
+	public:
+	MirrorSystem mirror;
+
+	MirrorWorld()
+	 : WorldBase({mirror}), mirror(getIDToEntityFunc()) {}
+
+	void customUpdate(double) {}
+};
+
+//loadSnapshot lands the same entities as loadEntities, keeps MultiSystem ModuleIDs and runs postCreate once per
+// module; a column whose System here has other types goes through PartialComponents instead
+static void testLoadSnapshot() {
+	ExampleGameWorld source;
+	std::vector<EntityID> eids = spawnBuffed(source, 30);
+	for (int i = 0; i < 10; i++) source.appendComponent(eids[i], BuffPC(BuffValue{2., 50.}));
+	std::vector<EntityID> plain;
+	for (int i = 0; i < 5; i++) {
+		plain.push_back(source.makeEntity(Placement(Vec3(0, i, 0)), new HealthPC(HealthValue(100.))));
+		source.healthSystem.applyDamage(source.getEntity(plain.back()), 10. * i);
+	}
+	source.update(0.1);
+
+	std::vector<EntityID> all = eids;
+	all.insert(all.end(), plain.begin(), plain.end());
+	std::vector<SavedEntity> saved = source.saveEntities(all);
+
+	LoadWorld bySnapshot, bySaves;
+	std::vector<EntityID> loaded = bySnapshot.loadSnapshot(source.snapshot());
+	bySaves.loadEntities(saved);
+
+	CHECK(loaded.size() == all.size());
+	CHECK(sameSaves(bySnapshot.saveEntities(all), saved));
+	CHECK(sameSaves(bySnapshot.saveEntities(all), bySaves.saveEntities(all)));
+	CHECK(bySnapshot.health.postCreates == 35);
+	CHECK(bySnapshot.buffs.postCreates == 30);
+	for (EntityID eid : eids) CHECK(bySnapshot.buffs.getModuleIDs(eid) == source.buffSystem.getModuleIDs(eid));
+	for (EntityID eid : all) {
+		CHECK(std::memcmp(&bySnapshot.getEntity(eid).pos, &source.getEntity(eid).pos, sizeof(Placement)) == 0);
+	}
+
+	//loaded EIDs are claimed: new entities don't collide with them
+	EntityID fresh = bySnapshot.makeEntity(Placement(), new HealthPC(HealthValue(1.)));
+	for (EntityID eid : all) CHECK(fresh.slot() != eid.slot());
+
+	MirrorWorld mirrored;
+	mirrored.loadSnapshot(source.snapshot(plain));
+	CHECK(mirrored.mirror.moduleCount() == plain.size());
+	for (int i = 0; i < 5; i++) {
+		CHECK(static_cast<HealthMirror*>(mirrored.mirror.modulePtr(plain[i]))->hp == 100. - 10. * i);
+	}
+}
+
+///a reference to another entity; not RawModuleCopy, since duplicates must point at the duplicated target
+struct Link {
+	EntityID target;
+};
+
+class LinkPC : public PartialComponent<Link> {
+	public:
+	static int remapped;
+
+	LinkPC(Link l, SystemType st)
+	 : PartialComponent<Link>(l, st) {}
+
+	std::shared_ptr<IPartialComponent> duplicateUpdate(const std::unordered_map<EntityID, EntityID>& eidMapping) {
+		remapped++;
+		auto it = eidMapping.find(t.target);
+		return std::make_shared<LinkPC>(Link{it == eidMapping.end() ? t.target : it->second}, sysType);
+	}
+};
+int LinkPC::remapped = 0;
+
+template<> struct ModuleRecreator<Link, Link> {
+	static constexpr bool supported = true;
+
+	static std::shared_ptr<PartialComponent<Link>> recreate(const Link& l, SystemType st) {
+		return std::make_shared<LinkPC>(l, st);
+	}
+};
+
+class LinkSystem : public SimpleSystem<Link, SystemType::Buffs> {
+	public:
+	LinkSystem(std::function<Entity*(EntityID)> idToEntity)
+	 : SimpleSystem(idToEntity) {}
+
+	void customUpdate() {}
+};
+
+class LinkWorld : public WorldBase {
+	public:
+	CountingHealth health;
+	LinkSystem links;
+
+	LinkWorld()
+	 : WorldBase({health, links}), health(getIDToEntityFunc()), links(getIDToEntityFunc()) {}
+
+	void customUpdate(double) {}
+};
+
+//duplicateSnapshot puts every module under its entity's new EID: RawModuleCopy columns are copied as is, and other
+// modules go through duplicateUpdate, so links between duplicated entities point at the duplicates
+static void testDuplicateSnapshot() {
+	LinkWorld source;
+	EntityID a = source.makeEntity(Placement(Vec3(1, 0, 0)), new HealthPC(HealthValue(10.)));
+	EntityID b = source.makeEntity(Placement(Vec3(2, 0, 0)), new HealthPC(HealthValue(20.)));
+	EntityID outside = source.makeEntity(std::vector<std::shared_ptr<IPartialComponent>>());
+	source.appendComponent(a, PartialComponent<Link>(Link{b}, SystemType::Buffs));
+	source.appendComponent(b, PartialComponent<Link>(Link{outside}, SystemType::Buffs));
+
+	LinkWorld target;
+	target.makeEntity(Placement(), new HealthPC(HealthValue(1.)));
+	int instantiated = target.health.instantiated;
+	LinkPC::remapped = 0;
+
+	std::vector<EntityID> copies = target.duplicateSnapshot(source.snapshot({a, b}));
+	CHECK(copies.size() == 2);
+	EntityID a2 = copies[0], b2 = copies[1];
+	CHECK(!(a2 == a) && !(b2 == b) && !(a2 == b2));
+
+	CHECK(target.getEntity(a2).get<CountingHealth>().curHealth == 10.);
+	CHECK(target.getEntity(b2).get<CountingHealth>().curHealth == 20.);
+	CHECK(target.getEntity(b2).pos.pos.x == 2.);
+	CHECK(target.health.instantiated == instantiated);
+	CHECK(target.health.postCreates == 3);
+
+	CHECK(LinkPC::remapped == 2);
+	CHECK(target.getEntity(a2).get<LinkSystem>().target == b2);
+	CHECK(target.getEntity(b2).get<LinkSystem>().target == outside);
+}
+
+static void testStateHash() {
+	ExampleGameWorld a, b;
+	EntityID eid = spawnBuffed(a, 50)[0];
+	spawnBuffed(b, 50);
+	for (int i = 0; i < 5; i++) {
+		a.update(0.1);
+		b.update(0.1);
+	}
+	CHECK(a.stateHash() == b.stateHash());
+	CHECK(a.stateHash() == a.fullStateHash());
+
+	//a touch()ed change shows up in the incremental hash
+	a.healthSystem.applyDamage(a.getEntity(eid), 1.);
+	CHECK(a.stateHash() != b.stateHash());
+	CHECK(a.stateHash() == a.fullStateHash());
+
+	//an untouched write doesn't, which verify mode catches
+	b.setStateHashVerify(true);
+	b.getEntity(eid).get<HealthSystem>().curHealth = 0.;
+	bool threw = false;
+	try { b.stateHash(); }
+	catch (std::runtime_error&) { threw = true; }
+	CHECK(threw);
+}
+
+static void testFrontBuffer() {
+	ExampleGameWorld world;
+	EntityID eid = world.makeEntity(Placement(), new HealthPC(HealthValue(100.)));
+	FrontBuffer<HealthSystem>& front = world.doubleBuffer(world.healthSystem);
+	CHECK(&front == &world.doubleBuffer(world.healthSystem));
+	CHECK(front.read().get(eid) != nullptr && front.read().get(eid)->curHealth == 100.);
+
+	//changes during a frame only show once endFrame publishes them
+	world.beginFrame(0.1);
+	world.healthSystem.applyDamage(world.getEntity(eid), 30.);
+	EntityID late = world.makeEntity(Placement(), new HealthPC(HealthValue(5.)));
+	CHECK(front.read().get(eid)->curHealth == 100.);
+	CHECK(!front.read().has(late));
+	world.endFrame();
+
+	{
+		auto view = front.read();
+		CHECK(view.get(eid)->curHealth == 70.);
+		CHECK(view.has(late));
+		CHECK(view.frame() == world.frame());
+	}
+
+	world.deleteEntity(late);
+	world.update(0.1);
+	CHECK(!front.read().has(late));
+	CHECK(front.read().size() == 1);
+}
+
+static void testExtract() {
+	ExampleGameWorld world;
+	Extractor x(TransformFormat::PosQuat, 32);
+	x.field<HealthSystem>(28, [] (const HealthValue& h) { return float(h.curHealth); });
+	world.setExtractor(&x);
+
+	std::vector<EntityID> eids;
+	for (int i = 0; i < 10; i++) eids.push_back(world.makeEntity(Placement(Vec3(i, 0, 0)), new HealthPC(HealthValue(10. + i))));
+	world.update(0.1);
+
+	std::vector<char> buffer(32 * 10);
+	std::vector<EntityID> out(10, -1);
+	auto field = [&] (std::size_t i, std::size_t offset) {
+		float f;
+		std::memcpy(&f, buffer.data() + i * 32 + offset, sizeof(float));
+		return f;
+	};
+
+	CHECK(world.extract(buffer.data(), out.data(), 10, ExtractMode::All) == 10);
+	for (std::size_t i = 0; i < 10; i++) {
+		int n = int(std::find(eids.begin(), eids.end(), out[i]) - eids.begin());
+		CHECK(field(i, 0) == float(n));
+		CHECK(field(i, 28) == float(10. + n));
+	}
+
+	//nothing changed since
+	CHECK(world.extract(buffer.data(), out.data(), 10, ExtractMode::Changed) == 0);
+
+	world.healthSystem.applyDamage(world.getEntity(eids[2]), 1.);
+	world.deleteEntity(eids[7]);
+	world.update(0.1);
+	CHECK(world.extract(buffer.data(), out.data(), 10, ExtractMode::Changed) == 1);
+	CHECK(out[0] == eids[2] && field(0, 28) == 11.f);
+	CHECK(x.removed().size() == 1 && x.removed()[0] == eids[7]);
+
+	bool threw = false;
+	try { world.extract(buffer.data(), out.data(), 2); }
+	catch (std::invalid_argument&) { threw = true; }
+	CHECK(threw);
+}
+
+static void testSleep() {
+	ExampleGameWorld world;
+	EntityID eid = world.makeEntity(Placement(), new HealthPC(HealthValue(100.)), new BuffPC(BuffValue{10., 100.}));
+
+	//slept before its buff has ticked, so no DamageEvent is in flight to wake it
+	world.sleep(eid);
+	CHECK(world.isAsleep(eid));
+	CHECK(world.awakeCount() == 0);
+
+	//its buff is paused along with it
+	for (int i = 0; i < 5; i++) world.update(0.1);
+	CHECK(world.isAsleep(eid));
+	CHECK(world.healthSystem.get(eid).curHealth == 100.);
+	world.buffSystem.applyFunctionToAllModules([&] (EntityID, Entity&, BuffValue& b) { CHECK(b.remaining == 100.); });
+
+	//touch()ing a module wakes it
+	world.healthSystem.applyDamage(world.getEntity(eid), 1.);
+	CHECK(!world.isAsleep(eid));
+	CHECK(world.awakeCount() == 1);
+
+	//and so does a timer
+	world.sleepFor(eid, 0.25);
+	CHECK(world.isAsleep(eid));
+	for (int i = 0; i < 4; i++) world.update(0.1);
+	CHECK(!world.isAsleep(eid));
+}
+
+static void testRateGroups() {
+	ExampleGameWorld world;
+	int runs = 0;
+	double seconds = 0.;
+	std::size_t group = world.addRateGroup(10., [&] (double dt) {
+		runs++;
+		seconds += dt;
+	});
+
+	for (int i = 0; i < 60; i++) world.update(1. / 60.);
+	CHECK(runs >= 9 && runs <= 11);
+	CHECK(world.rateGroupStats(group).runs == std::size_t(runs));
+	CHECK(seconds > 0.8 && seconds < 1.1);
+}
+
+//Entity::get/tryGet go through a per-entity module cache, which has to drop modules the System erases
+static void testModuleCache() {
+	ExampleGameWorld world;
+	EntityID eid = world.makeEntity(Placement(), new HealthPC(HealthValue(10.)), new BuffPC(BuffValue{1., 10.}));
+	Entity& e = world.getEntity(eid);
+	CHECK(e.tryGet<HealthSystem>() != nullptr);
+
+	world.healthSystem.destroyEntityModules(eid);
+	CHECK(e.tryGet<HealthSystem>() == nullptr);
+
+	world.appendComponent(eid, HealthPC(HealthValue(20.)));
+	CHECK(e.tryGet<HealthSystem>() != nullptr && e.get<HealthSystem>().curHealth == 20.);
+	world.removeComponent(eid, SystemType::Health);
+	CHECK(e.tryGet<HealthSystem>() == nullptr);
+}
+
+
+//logs MultiSystem removal hooks and observer notifications into one sequence, so their order shows
+class RemovalSystem : public SimpleMultiSystem<Elapsed, SystemType::Buffs> {
+	public:
+	std::vector<std::string> log;
+
+	RemovalSystem(std::function<Entity*(EntityID)> idToEntity)
+	 : SimpleMultiSystem(idToEntity) {}
+
+	void customUpdate() {}
+
+	void preRemove(EntityID eID, ModuleID mID) {
+		log.push_back("preRemove " + std::to_string(getModuleIDs(eID).size()));
+	}
+};
+
+class RemovalObserver : public ModuleObserver {
+	public:
+	std::vector<std::string>& log;
+
+	RemovalObserver(std::vector<std::string>& l)
+	 : log(l) {}
+
+	void moduleModified(SystemBase&, EntityID) { log.push_back("modified"); }
+	void moduleDestroyed(SystemBase&, EntityID) { log.push_back("destroyed"); }
+};
+
+class RemovalWorld : public WorldBase {
+	public:
+	RemovalSystem removals;
+
+	RemovalWorld()
+	 : WorldBase({removals}), removals(getIDToEntityFunc()) {}
+
+	void customUpdate(double) {}
+};
+
+//MultiSystem modules are removed whole, one at a time, or in batches; hooks run before observers hear of it
+static void testModuleRemoval() {
+	typedef std::vector<std::string> Log;
+
+	RemovalWorld world;
+	RemovalObserver observer(world.removals.log);
+	world.removals.addObserver(&observer);
+
+	std::vector<EntityID> eids;
+	for (int i = 0; i < 3; i++) {
+		eids.push_back(world.makeEntity(Placement(), new ElapsedPC(Elapsed{0.}), new ElapsedPC(Elapsed{1.}),
+		                                new ElapsedPC(Elapsed{2.})));
+	}
+	CHECK(world.removals.moduleCount() == 9);
+
+	world.removeComponent(eids[0], SystemType::Buffs);
+	CHECK((world.removals.log == Log{"preRemove 3", "preRemove 3", "preRemove 3", "destroyed"}));
+	CHECK(!world.removals.hasModules(eids[0]));
+	CHECK(world.getEntity(eids[0]).getRelatedSystems().count(&world.removals) == 0);
+
+	world.removals.log.clear();
+	std::vector<ModuleID> ids = world.removals.getModuleIDs(eids[1]);
+	world.removeComponent(eids[1], SystemType::Buffs, ids[0]);
+	CHECK((world.removals.log == Log{"preRemove 3", "modified"}));
+	CHECK(world.removals.getModuleIDs(eids[1]).size() == 2);
+
+	//a batch: the rest of eids[1], one of eids[2], and a deleted entity, which is skipped
+	EntityID gone = world.makeEntity(Placement(), new ElapsedPC(Elapsed{0.}));
+	ModuleID goneModule = world.removals.getModuleIDs(gone)[0];
+	world.deleteEntity(gone);
+	world.update(0.1);
+
+	world.removals.log.clear();
+	ModuleID kept = world.removals.getModuleIDs(eids[2])[1];
+	world.removeComponents(SystemType::Buffs, {std::make_pair(eids[1], ids[1]), std::make_pair(eids[1], ids[2]),
+	                                           std::make_pair(eids[2], world.removals.getModuleIDs(eids[2])[0]),
+	                                           std::make_pair(gone, goneModule)});
+	CHECK(!world.removals.hasModules(eids[1]));
+	CHECK(world.getEntity(eids[1]).getRelatedSystems().count(&world.removals) == 0);
+	CHECK(world.removals.getModuleIDs(eids[2]).size() == 2);
+	CHECK(world.removals.getModuleIDs(eids[2])[0] == kept || world.removals.getModuleIDs(eids[2])[1] == kept);
+	CHECK(world.removals.moduleCount() == 2);
+	CHECK(std::count(world.removals.log.begin(), world.removals.log.end(), "destroyed") == 1);
+
+	//BuffSystem drops a frame's expired buffs in one batch
+	ExampleGameWorld game;
+	std::vector<EntityID> buffed = spawnBuffed(game, 10);
+	for (EntityID eid : buffed) game.appendComponent(eid, BuffPC(BuffValue{1., 100.}));
+	CHECK(game.buffSystem.moduleCount() == 20);
+	for (int i = 0; i < 15; i++) game.update(0.1);
+	CHECK(game.buffSystem.moduleCount() == 10);
+	for (EntityID eid : buffed) CHECK(game.buffSystem.getModuleIDs(eid).size() == 1);
+}
+
+//an index made after modules exist starts with all of them, follows touched modules, and answers queries in key order
+static void testFieldIndex() {
+	ExampleGameWorld world;
+	std::vector<EntityID> eids;
+	for (int i = 0; i < 50; i++) eids.push_back(world.makeEntity(Placement(), new HealthPC(HealthValue(100. + i))));
+
+	FieldIndex<HealthSystem, double> byHealth(world.healthSystem, [] (const HealthValue& h) { return h.curHealth; });
+	CHECK(byHealth.size() == 50);
+	CHECK(byHealth.front().second == eids[0]);
+
+	world.healthSystem.applyDamage(world.getEntity(eids[30]), 100.);
+	world.healthSystem.applyDamage(world.getEntity(eids[40]), 200.);
+	CHECK(*byHealth.keyOf(eids[30]) == 30.);
+
+	std::vector<EntityID> dead;
+	byHealth.collectUpTo(40., dead);
+	CHECK(dead == std::vector<EntityID>({eids[40], eids[30]}));
+
+	std::vector<double> first;
+	for (int pass = 0; pass < 2; pass++) {
+		first.clear();
+		byHealth.forEachFirst(4, [&] (EntityID, double hp) { first.push_back(hp); });
+		CHECK(first == std::vector<double>({-60., 30., 100., 101.}));
+	}
+
+	world.deleteEntity(eids[40]);
+	CHECK(byHealth.size() == 49);
+	CHECK(byHealth.keyOf(eids[40]) == nullptr);
+}
+
+
+class BroadphaseWorld : public WorldBase {
+	public:
+	BroadphaseSystem broadphase;
+
+	BroadphaseWorld()
+	 : WorldBase({broadphase}), broadphase(getIDToEntityFunc(), getEventBus()) {}
+
+	void customUpdate(double) {
+		broadphase.update();
+	}
+};
+
+static EntityID makeBox(BroadphaseWorld& world, double x) {
+	return world.makeEntity(Placement(Vec3(x, 0, 0)), new ColliderPC(Collider{Vec3(1, 1, 1), Vec3()}));
+}
+
+//the overlap events of the last update, which the update after it publishes
+template <class Event>
+static std::vector<std::pair<EntityID, EntityID>> publishedOverlaps(BroadphaseWorld& world) {
+	std::vector<std::pair<EntityID, EntityID>> out;
+	for (auto& e : world.eventChannel<Event>().events()) out.push_back(std::make_pair(e.eID, e.other));
+	return out;
+}
+
+//pairs follow the colliders as they move, are created and are destroyed, with one Begin/End event per change
+static void testBroadphase() {
+	typedef std::vector<std::pair<EntityID, EntityID>> Pairs;
+
+	BroadphaseWorld world;
+	EntityID a = makeBox(world, 0.);
+	EntityID b = makeBox(world, 1.5);
+	EntityID c = makeBox(world, 10.);
+	world.update(0.1);
+
+	CHECK(world.broadphase.overlapping(a, b) && world.broadphase.overlapping(b, a));
+	CHECK(!world.broadphase.overlapping(a, c) && !world.broadphase.overlapping(b, c));
+	CHECK(world.broadphase.pairCount() == 1);
+	Pairs pairs;
+	world.broadphase.forEachPair([&] (EntityID x, EntityID y) { pairs.push_back(std::make_pair(x, y)); });
+	CHECK(pairs == Pairs{std::make_pair(a, b)});
+
+	world.update(0.1);
+	CHECK(publishedOverlaps<OverlapBeginEvent>(world) == Pairs{std::make_pair(a, b)});
+	CHECK(publishedOverlaps<OverlapEndEvent>(world).empty());
+
+	//c moves into b, but not a
+	world.getEntity(c).pos = Placement(Vec3(2.5, 0, 0));
+	world.update(0.1);
+	CHECK(world.broadphase.overlapping(b, c) && !world.broadphase.overlapping(a, c));
+	world.update(0.1);
+	CHECK(publishedOverlaps<OverlapBeginEvent>(world) == Pairs{std::make_pair(b, c)});
+
+	//and back out
+	world.getEntity(c).pos = Placement(Vec3(20, 0, 0));
+	world.update(0.1);
+	CHECK(!world.broadphase.overlapping(b, c));
+	world.update(0.1);
+	CHECK(publishedOverlaps<OverlapEndEvent>(world) == Pairs{std::make_pair(b, c)});
+	CHECK(publishedOverlaps<OverlapBeginEvent>(world).empty());
+
+	//destroying a collider ends its pairs at the next update
+	world.broadphase.destroyEntityModules(a);
+	CHECK(!world.broadphase.overlapping(a, b));
+	world.update(0.1);
+	CHECK(world.broadphase.pairCount() == 0);
+	world.update(0.1);
+	CHECK(publishedOverlaps<OverlapEndEvent>(world) == Pairs{std::make_pair(a, b)});
+
+	//and so does deleting its entity
+	EntityID d = makeBox(world, 1.);
+	world.update(0.1);
+	CHECK(world.broadphase.overlapping(b, d));
+	world.deleteEntity(b);
+	world.update(0.1);
+	CHECK(world.broadphase.pairCount() == 0);
+	CHECK(!world.broadphase.overlapping(b, d));
+	world.update(0.1);
+	CHECK(publishedOverlaps<OverlapEndEvent>(world) == Pairs{std::make_pair(b, d)});
+
+	//a new collider in the deleted one's place pairs up as a new entity
+	EntityID e = makeBox(world, 1.5);
+	world.update(0.1);
+	CHECK(world.broadphase.overlapping(d, e));
+	CHECK(world.broadphase.pairCount() == 1);
+
+	//a row added at once pairs up with its neighbours only
+	std::vector<EntityID> row;
+	for (int i = 0; i < 20; i++) {
+		row.push_back(world.makeEntity(Placement(Vec3(1.5 * i, 100, 0)), new ColliderPC(Collider{Vec3(1, 1, 1), Vec3()})));
+	}
+	world.update(0.1);
+	CHECK(world.broadphase.pairCount() == 20);
+	for (int i = 1; i < 20; i++) CHECK(world.broadphase.overlapping(row[i - 1], row[i]));
+	CHECK(!world.broadphase.overlapping(row[0], row[2]));
+
+	//a Collider changed through modify() is picked up at the next update
+	world.broadphase.modify(c, [] (Collider& col) { col.halfExtents.x = 19.; });
+	world.update(0.1);
+	CHECK(world.broadphase.overlapping(c, d) && world.broadphase.overlapping(c, e));
+	CHECK(world.broadphase.pairCount() == 22);
+}
+
+
+class NavWorld : public WorldBase {
+	public:
+	NavGrid grid;
+	NavSystem nav;
+
+	NavWorld()
+	 : WorldBase({nav}), grid(20, 20), nav(getIDToEntityFunc(), grid, 4) {}
+
+	void customUpdate(double) {
+		nav.update();
+	}
+};
+
+static const NavAgent& agentOf(NavWorld& world, EntityID eid) {
+	return world.getEntity(eid).get<NavSystem>();
+}
+
+static std::size_t resultsFor(const NavWorld& world, EntityID eid) {
+	std::size_t out = 0;
+	for (auto& r : world.nav.results()) if (r.eID == eid) out++;
+	return out;
+}
+
+//a goal many agents ask for gets one flow field they all follow, the rest get paths, and each agent's last request
+// in a frame is the only one solved
+static void testNav() {
+	NavWorld world;
+	world.grid.setCost(Coord(10, 0), 0);
+
+	std::vector<EntityID> agents;
+	for (int i = 0; i < 8; i++) agents.push_back(world.makeEntity(Placement(), new NavAgentPC(NavAgent())));
+	std::vector<std::shared_ptr<IPartialComponent>> noAgent;
+	EntityID bystander = world.makeEntity(noAgent);
+	world.update(0.1);
+
+	Coord shared(15, 15);
+	for (int i = 0; i < 5; i++) world.nav.requestPath(agents[i], Coord(i, 0), shared);
+	//agents 0 and 5 change their minds; only their last request counts
+	world.nav.requestPath(agents[0], Coord(0, 0), shared);
+	world.nav.requestPath(agents[5], Coord(0, 19), shared);
+	world.nav.requestPath(agents[5], Coord(0, 0), Coord(3, 3));
+	world.nav.requestPath(agents[6], Coord(0, 0), Coord(10, 0));
+	world.nav.requestPath(bystander, Coord(0, 0), shared);
+	world.update(0.1);
+
+	CHECK(world.nav.results().size() == 7);
+	for (int i = 0; i < 7; i++) CHECK(resultsFor(world, agents[i]) == 1);
+	CHECK(resultsFor(world, agents[7]) == 0);
+	CHECK(resultsFor(world, bystander) == 0);
+
+	const FlowField* field = world.nav.flowField(agents[0]);
+	CHECK(field != nullptr && field->goal() == shared);
+	for (int i = 0; i < 5; i++) {
+		CHECK(world.nav.flowField(agents[i]) == field);
+		CHECK(agentOf(world, agents[i]).status == NavStatus::Flow);
+		CHECK(agentOf(world, agents[i]).path.empty());
+	}
+	if (field) CHECK(field->next(shared) == shared && !(field->next(Coord(0, 0)) == Coord(0, 0)));
+
+	//too few for a field of their own
+	const NavAgent& pathed = agentOf(world, agents[5]);
+	CHECK(pathed.status == NavStatus::Path && world.nav.flowField(agents[5]) == nullptr);
+	CHECK(!pathed.path.empty() && pathed.path.front() == Coord(0, 0) && pathed.path.back() == Coord(3, 3));
+	CHECK(agentOf(world, agents[6]).status == NavStatus::Unreachable);
+	CHECK(agentOf(world, agents[7]).status == NavStatus::Idle);
+
+	//a goal that already has a field shares it with a lone newcomer
+	world.nav.requestPath(agents[7], Coord(19, 0), shared);
+	world.update(0.1);
+	CHECK(world.nav.results().size() == 1);
+	CHECK(agentOf(world, agents[7]).status == NavStatus::Flow);
+	CHECK(world.nav.flowField(agents[7]) == world.nav.flowField(agents[1]));
+
+	//leaving for a path stops following
+	world.nav.requestPath(agents[7], Coord(19, 0), Coord(19, 5));
+	world.update(0.1);
+	CHECK(world.nav.flowField(agents[7]) == nullptr);
+	CHECK(agentOf(world, agents[7]).status == NavStatus::Path);
+	CHECK(world.nav.flowField(agents[1]) != nullptr);
+}
+
+
+int main() {
+	testEntityChurn();
+	testIDThreads();
+	testTags();
+	testFixedStep();
+	testEventBus();
+	testStaticWorld();
+	testPrefabs();
+	testEmplace();
+	testTasks();
+	testCompaction();
+	testJournal();
+	testSnapshotSave();
+	testLoadSnapshot();
+	testDuplicateSnapshot();
+	testStateHash();
+	testFrontBuffer();
+	testExtract();
+	testSleep();
+	testRateGroups();
+	testModuleCache();
+	testModuleRemoval();
+	testFieldIndex();
+	testBroadphase();
+	testNav();
+
+	std::cout<<(failures ? "FAILED" : "passed")<<": "<<failures<<" failed checks"<<std::endl;
+	return failures ? 1 : 0;
+}
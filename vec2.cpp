@@ -116,23 +116,17 @@ const Vec2 Vec2::normalize() const {
 }
 
 std::vector<Vec2> Vec2::getNeighbors() const {
-    Vec2 center = this->normalizeManhattan();
-
-    Vec2 neighbors[] = {center + Vec2(-1, -1), center + Vec2(0, -1), center + Vec2(1, -1),
-                        center + Vec2(-1,  0), /*ignore center pos*/ center + Vec2(1,  0),
-                        center + Vec2(-1,  1), center + Vec2(0,  1), center + Vec2(1,  1)};
-
-    return std::vector<Vec2>(neighbors, neighbors + 8);
+    std::vector<Vec2> out;
+    out.reserve(8);
+    forEachNeighbor([&] (const Vec2& n) { out.push_back(n); });
+    return out;
 }
 
 std::vector<Coord> Coord::getNeighbors() const {
-    Coord center = *this;
-
-    Coord neighbors[] = {center + Coord(-1, -1), center + Coord(0, -1), center + Coord(1, -1),
-                        center + Coord(-1,  0), /*ignore center pos*/ center + Coord(1,  0),
-                        center + Coord(-1,  1), center + Coord(0,  1), center + Coord(1,  1)};
-
-    return std::vector<Coord>(neighbors, neighbors + 8);
+    std::vector<Coord> out;
+    out.reserve(8);
+    forEachNeighbor([&] (const Coord& n) { out.push_back(n); });
+    return out;
 }
 
 Vec2 Coord::toVec2() const {
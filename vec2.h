@@ -3,6 +3,7 @@
 
 #include <functional>
 #include <vector>
+#include <cstdint>
 #include <iostream>
 #include <glm/glm.hpp>
 
@@ -20,6 +21,15 @@ struct Coord {
     operator Vec2() const;
     bool operator==(const Coord& in) const;
     std::vector<Coord> getNeighbors() const;
+    ///f(Coord) for the 8 neighbors, in getNeighbors order, without allocating
+    template <class F>
+    void forEachNeighbor(F f) const {
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                if (dx != 0 || dy != 0) f(Coord(x + dx, y + dy));
+            }
+        }
+    }
     Vec2 toVec2() const;
     int dot(const Coord& other) const;
 
@@ -62,6 +72,9 @@ struct Vec2 {
     double magManhattan() const;
     double getDistanceManhattan(const Vec2& in) const;
     std::vector<Vec2> getNeighbors() const;
+    ///f(Vec2) for what getNeighbors returns, without allocating
+    template <class F>
+    void forEachNeighbor(F f) const;
     explicit operator Coord() const;
     const Vec2 normalize() const;
 
@@ -81,6 +94,16 @@ extern const Vec2 operator-(double lhs, const Vec2& rhs);
 extern const Vec2 operator*(double lhs, const Vec2& rhs);
 extern const Vec2 operator/(double lhs, const Vec2& rhs);
 
+template <class F>
+void Vec2::forEachNeighbor(F f) const {
+    Vec2 center = this->normalizeManhattan();
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            if (dx != 0 || dy != 0) f(center + Vec2(dx, dy));
+        }
+    }
+}
+
 namespace std {
     template<>
     struct hash<Vec2> {
@@ -96,8 +119,15 @@ namespace std {
 
     template<>
     struct hash<Coord> {
+        ///both coordinates packed into 64 bits, then mixed (the fmix64 finalizer), so nearby cells spread over buckets
         std::size_t operator() (const Coord& c) const {
-            return (c.x << sizeof(int)/2) ^ c.y;
+            std::uint64_t h = (std::uint64_t(std::uint32_t(c.x)) << 32) | std::uint32_t(c.y);
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+            return std::size_t(h);
         }
     };
 }
@@ -1,8 +1,19 @@
 #include "worldbase.h"
 
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
 
 WorldBase::WorldBase(std::vector<std::reference_wrapper<SystemBase>> systems)
-    : typeToSystem(), maxID(0), knownSystems(systems) {};
+    : typeToSystem(), knownSystems(systems),
+      fixedStep(1./60.), accumulator(0.), maxSubSteps(4), catchUpPolicy(CatchUpPolicy::Drop),
+      compactionBudget(0.), compactionCursor(0), journal(nullptr), extractor(nullptr), simTime(0.),
+      frameCount(0), placementsHash(0), verifyStateHash(false) {
+    mutationWaker.world = this;
+}
 WorldBase::~WorldBase() {
     for (auto& e : entities) e.second->clearRelatedSystems();
 }
@@ -16,25 +27,22 @@ void WorldBase::constructSystemTypemap() {
         }
 
         typeToSystem.insert(std::pair<SystemType, SystemBase&>(type, s.get()));
+        s.get().addObserver(&mutationWaker);
     }
 
     knownSystems.clear();
 }
 
-Entity& getIth(std::unordered_map<int, std::unique_ptr<Entity>>& list, int i) {
-    return *list.at(i);
-}
-
 std::function<Entity*(EntityID)> WorldBase::getIDToEntityFunc() {
-    return [=] (EntityID ID) -> Entity* {
-        if (entities.count(ID) == 0) return nullptr;
-        return entities.at(ID).get();
+    return [this] (EntityID ID) -> Entity* {
+        return entities.get(ID);
     };
 }
 
 void WorldBase::deleteEntity(EntityID eid) {
     assert(hasEntity(eid));
-    entities.erase(eid);
+    if (journal) journal->entityDeleted(eid);
+    eraseEntity(eid);
 }
 
 EntityID WorldBase::makeEntityRefList(const std::vector<std::reference_wrapper<IPartialComponent>>& componentList, Placement p) {
@@ -56,30 +64,104 @@ EntityID WorldBase::makeEntity(const std::vector<std::shared_ptr<IPartialCompone
 
 
 void WorldBase::_makeEntity(EntityID ID, const std::vector<std::reference_wrapper<IPartialComponent>>& componentList, Placement p) {
-    if (entities.count(ID)) throw std::invalid_argument("Tried to create an entity with an already existing EID");
+    if (entities.slotTaken(ID)) {
+        throw std::invalid_argument("Tried to create an entity with an already existing EID (or its slot)");
+    }
+
+    insertEntity(std::make_unique<Entity>(ID, p, componentList, getTypeToSystemFunc()));
+}
 
-    std::unique_ptr<Entity> e = std::make_unique<Entity>(ID, p, componentList, getTypeToSystemFunc());
 
-    entities.insert(std::make_pair<EntityID, std::unique_ptr<Entity>>(EntityID(ID), std::move(e)));
+void WorldBase::_makeEntity(EntityID ID, const std::vector<std::shared_ptr<IPartialComponent>>& componentList, Placement p) {
+    if (entities.slotTaken(ID)) {
+        throw std::invalid_argument("Tried to create an entity with an already existing EID (or its slot)");
+    }
 
-    for (auto& r : getEntity(ID).getRelatedSystems()) r->postCreate(ID);
+    insertEntity(std::make_unique<Entity>(ID, p, componentList, getTypeToSystemFunc()));
 }
 
+Prefab WorldBase::compilePrefab(const std::vector<std::shared_ptr<IPartialComponent>>& componentList) {
+    if (typeToSystem.size() == 0) constructSystemTypemap();
 
-void WorldBase::_makeEntity(EntityID ID, const std::vector<std::shared_ptr<IPartialComponent>>& componentList, Placement p) {
-    if (entities.count(ID)) throw std::invalid_argument("Tried to create an entity with an already existing EID");
+    std::function<SystemBase&(SystemType)> checkedTypeToSystem = [this] (SystemType st) -> SystemBase& {
+        if (!typeToSystem.count(st)) {
+            throw std::invalid_argument("Prefab uses SystemType " + std::to_string(st) + ", which this world doesn't have");
+        }
+        return typeToSystem.at(st);
+    };
+
+    Prefab out(this);
+
+    for (auto& pc : componentList) {
+        assert(pc.get() != nullptr);
+
+        std::unique_ptr<IBoundComponent> bound = pc->bind(checkedTypeToSystem);
+
+        SystemBase* sys = &bound->getSystem();
+        if (std::find(out.systems.begin(), out.systems.end(), sys) == out.systems.end()) out.systems.push_back(sys);
+
+        out.components.push_back(std::move(bound));
+    }
+
+    return out;
+}
+
+EntityID WorldBase::instantiate(const Prefab& prefab, Placement p) {
+    assert(prefab.world == this && "Prefab was compiled for a different world");
+
+    EntityID ID = makeNewID();
+    std::unique_ptr<Entity> e = std::make_unique<Entity>(ID, p);
+
+    for (auto& c : prefab.components) c->create(ID);
+    for (SystemBase* s : prefab.systems) e->addRelatedSystem(s);
+
+    insertEntity(std::move(e));
+
+    return ID;
+}
+
+std::vector<EntityID> WorldBase::instantiate(const Prefab& prefab, const std::vector<Placement>& placements) {
+    std::vector<EntityID> out;
+    out.reserve(placements.size());
+    entities.reserve(entities.size() + placements.size());
+
+    for (auto& p : placements) out.push_back(instantiate(prefab, p));
+
+    return out;
+}
+
+Entity& WorldBase::insertEntity(std::unique_ptr<Entity>&& e, bool runPostCreate) {
+    EntityID ID = e->getID();
+    if (entities.slotTaken(ID)) {
+        throw std::invalid_argument("Tried to create an entity with an already existing EID (or its slot)");
+    }
+
+    if (typeToSystem.size() == 0) constructSystemTypemap();
 
-    std::unique_ptr<Entity> e = std::make_unique<Entity>(ID, p, componentList, getTypeToSystemFunc());
+    Entity& out = *e;
+    entities.insert(std::make_pair(ID, std::move(e)));
+    addAwake(out);
+
+    if (journal) journal->entityCreated(ID, out.pos);
+    if (extractor) extractor->created.push_back(ID);
+
+    if (runPostCreate) for (auto& r : out.getRelatedSystems()) r->postCreate(ID);
+
+    return out;
+}
 
-    entities.insert(std::make_pair<EntityID, std::unique_ptr<Entity>>(EntityID(ID), std::move(e)));
+EntityID WorldBase::makeEntityNextFrame(std::vector<std::unique_ptr<IPartialComponent>>&& list, Placement p) {
+    std::vector<std::shared_ptr<IPartialComponent>> shared;
+    shared.reserve(list.size());
+    for (auto& pc : list) shared.push_back(std::move(pc));
 
-    for (auto& r : getEntity(ID).getRelatedSystems()) r->postCreate(ID);
+    return makeEntityNextFrame(std::move(shared), p);
 }
 
-EntityID WorldBase::makeEntityNextFrame(std::vector<std::unique_ptr<IPartialComponent>>&& list) {
+EntityID WorldBase::makeEntityNextFrame(std::vector<std::shared_ptr<IPartialComponent>> list, Placement p) {
     EntityID ID = makeNewID();
 
-    creationQueue.emplace(ID, std::move(list));
+    creationQueue.push(CreationQueue::Entry{ID, std::move(list), p});
 
     return ID;
 }
@@ -89,7 +171,9 @@ void WorldBase::deleteEntityNextFrame(EntityID ID) {
 }
 
 Entity& WorldBase::getEntity(EntityID i) {
-    return *entities.at(i);
+    Entity* e = entities.get(i);
+    if (e == nullptr) throw std::out_of_range("WorldBase::getEntity: no entity " + std::to_string(i.ID));
+    return *e;
 }
 
 std::function<SystemBase&(SystemType)> WorldBase::getTypeToSystemFunc() {
@@ -102,31 +186,415 @@ std::function<SystemBase&(SystemType)> WorldBase::getTypeToSystemFunc() {
 }
 
 
-void WorldBase::update(double deltaTime) {
+void WorldBase::recordPhase(UpdatePhase p, AllocationStats& phaseStart) {
+    AllocationStats now = AllocationCounter::current();
+    frameAllocations.phases[(int) p] = now - phaseStart;
+    phaseStart = now;
+}
+
+void WorldBase::beginFrame(double deltaTime) {
+    phaseStart = AllocationCounter::current();
+
+    simTime += deltaTime;
+
+    //make last frame's events visible to this frame's consumers, and wake anything they (or timers) name
+    eventBus.publish();
+    runWakers();
+    recordPhase(UpdatePhase::Events, phaseStart);
+
     //delete all entities flagged for deletion
-    for (auto& i : deletionQueue) entities.erase(i);
+    for (auto& i : deletionQueue) {
+        if (!entities.count(i)) continue;
+
+        if (journal) journal->entityDeleted(i);
+        eraseEntity(i);
+    }
     deletionQueue.clear();
+    recordPhase(UpdatePhase::Deletion, phaseStart);
+
+    //create all new entities, from every thread's queue, in EID order
+    creationQueue.collect(creating);
+    for (auto& c : creating) _makeEntity(c.eID, c.components, c.p);
+    creating.clear();
+    recordPhase(UpdatePhase::Creation, phaseStart);
+
+    for (Entity* e : awakeEntities) e->updatePrevPos(deltaTime);
+    recordPhase(UpdatePhase::Transforms, phaseStart);
+
+    tasks.update(deltaTime);
+    recordPhase(UpdatePhase::Tasks, phaseStart);
+
+    customUpdate(deltaTime);
+    recordPhase(UpdatePhase::Custom, phaseStart);
+
+    runRateGroups(deltaTime);
+    recordPhase(UpdatePhase::RateGroups, phaseStart);
+}
+
+void WorldBase::endFrame() {
+    if (journal) journalFrame();
+    recordPhase(UpdatePhase::Journaling, phaseStart);
+
+    frameCount++;
+    for (auto& f : frontBuffers) f.second->publish(frameCount);
+    recordPhase(UpdatePhase::Publishing, phaseStart);
+
+    if (compactionBudget > 0.) compact(compactionBudget);
+    recordPhase(UpdatePhase::Compaction, phaseStart);
+}
+
+void WorldBase::addAwake(Entity& e) {
+    e.asleep = false;
+    e.awakeIndex = awakeEntities.size();
+    awakeEntities.push_back(&e);
+}
+
+void WorldBase::removeAwake(Entity& e) {
+    if (e.awakeIndex < 0) return;
+
+    Entity* last = awakeEntities.back();
+    awakeEntities[e.awakeIndex] = last;
+    last->awakeIndex = e.awakeIndex;
+    awakeEntities.pop_back();
+    e.awakeIndex = -1;
+}
+
+void WorldBase::eraseEntity(EntityID eid) {
+    auto it = entities.find(eid);
+    if (it == entities.end()) return;
+
+    removeAwake(*it->second);
+    if (stateHasher) placementsHash ^= it->second->placementHash;
+    if (extractor) extractor->erased.push_back(eid);
+    entities.erase(it);
+    ids.release(eid);
+}
+
+void WorldBase::sleep(EntityID eid) {
+    Entity& e = getEntity(eid);
+    e.wakeAt = -1.;
+    if (e.asleep) return;
+
+    //sleeping entities aren't rescanned, so their Placement has to be in the hash before they drop out
+    if (stateHasher) rehashPlacement(e);
+
+    e.asleep = true;
+    e.settle();
+    //its last extracted record may have been mid-interpolation, and it won't be scanned while asleep
+    if (extractor) extractor->settled.push_back(eid);
+    removeAwake(e);
+    for (SystemBase* s : e.getRelatedSystems()) s->setAwake(eid, false);
+}
+
+void WorldBase::sleepFor(EntityID eid, double seconds) {
+    sleep(eid);
+
+    Entity& e = getEntity(eid);
+    e.wakeAt = simTime + seconds;
+    wakeTimers.push(WakeTimer{e.wakeAt, eid});
+}
+
+void WorldBase::wake(EntityID eid) {
+    Entity& e = getEntity(eid);
+    if (!e.asleep) return;
+
+    addAwake(e);
+    e.wakeAt = -1.;
+    for (SystemBase* s : e.getRelatedSystems()) s->setAwake(eid, true);
+}
+
+void WorldBase::wakeIfAsleep(EntityID eid) {
+    //modules are created before their Entity is inserted, so eid may not exist yet
+    auto it = entities.find(eid);
+    if (it != entities.end() && it->second->asleep) wake(eid);
+}
+
+void WorldBase::runWakers() {
+    for (auto& w : eventWakers) w();
+
+    while (!wakeTimers.empty() && wakeTimers.top().at <= simTime) {
+        WakeTimer t = wakeTimers.top();
+        wakeTimers.pop();
+
+        //stale if the entity's gone, already woke, or was put back to sleep with another deadline
+        auto it = entities.find(t.eID);
+        if (it != entities.end() && it->second->asleep && it->second->wakeAt == t.at) wake(t.eID);
+    }
+}
+
+std::size_t WorldBase::addRateGroup(double hz, std::function<void(double)> func, double budgetSeconds, double phase) {
+    assert(hz > 0. && phase >= 0. && phase < 1.);
+
+    double period = 1. / hz;
+    //phase 0 runs on the next update
+    rateGroups.push_back(RateGroup{period, budgetSeconds, period * (1. - phase), period, func, RateGroupStats()});
+    return rateGroups.size() - 1;
+}
+
+void WorldBase::resetRateGroupStats() {
+    for (auto& g : rateGroups) g.stats = RateGroupStats();
+}
+
+void WorldBase::runRateGroups(double deltaTime) {
+    for (auto& g : rateGroups) {
+        g.accumulator += deltaTime;
+        g.sinceLastRun += deltaTime;
+        if (g.accumulator < g.period) continue;
+
+        auto start = std::chrono::steady_clock::now();
+        g.func(g.sinceLastRun);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        g.sinceLastRun = 0.;
+        g.accumulator -= g.period;
+
+        g.stats.runs++;
+        g.stats.totalSeconds += seconds;
+        g.stats.maxSeconds = std::max(g.stats.maxSeconds, seconds);
+        if (g.budget > 0. && seconds > g.budget) g.stats.overBudget++;
+
+        //one run per update; a group more than a period behind drops the missed ticks instead of bursting
+        if (g.accumulator >= g.period) {
+            g.stats.late++;
+            g.accumulator = std::fmod(g.accumulator, g.period);
+        }
+    }
+}
+
+void WorldBase::rehashPlacement(Entity& e) {
+    std::uint64_t h = StateHasher::hashPlacement(e.getID(), e.pos);
+    placementsHash ^= e.placementHash ^ h;
+    e.placementHash = h;
+}
+
+std::uint64_t WorldBase::fullStateHash() {
+    StateHasher scratch;
+    std::uint64_t out = 0;
 
-    //create all new entities
-    for (auto& i : creationQueue) {
-        EntityID ID = i.first;
-        std::vector<std::reference_wrapper<IPartialComponent>> inList;
+    for (auto& e : entities) {
+        out ^= StateHasher::hashPlacement(e.first, e.second->pos);
 
-        for (auto& j : i.second) {
-            assert(j.get() != nullptr);
-            inList.push_back(*j);
+        for (SystemBase* s : e.second->getRelatedSystems()) {
+            if (s->canEncodeModules()) out ^= scratch.hashModules(e.first, *s);
         }
+    }
+
+    return out;
+}
+
+std::uint64_t WorldBase::stateHash() {
+    if (!stateHasher) {
+        if (typeToSystem.size() == 0) constructSystemTypemap();
 
-        _makeEntity(ID, inList, Placement());
+        for (auto& s : typeToSystem) {
+            if (!s.second.canEncodeModules()) {
+                throw std::invalid_argument("Can't hash SystemType " + std::to_string(s.first) + "; its Instances have no JournalCodec");
+            }
+        }
+
+        stateHasher = std::make_unique<StateHasher>();
+        for (auto& s : typeToSystem) s.second.addObserver(stateHasher.get());
+
+        //everything existing counts as created
+        for (auto& e : entities) {
+            e.second->placementHash = 0;
+            rehashPlacement(*e.second);
+            for (SystemBase* s : e.second->getRelatedSystems()) {
+                if (s->canEncodeModules()) stateHasher->moduleCreated(*s, e.first);
+            }
+        }
+    }
+    else {
+        for (Entity* e : awakeEntities) rehashPlacement(*e);
     }
-    creationQueue.clear();
 
-    for (auto& e : entities) e.second->updatePrevPos(deltaTime);
+    std::uint64_t out = placementsHash ^ stateHasher->flush();
 
-    customUpdate(deltaTime);
+    if (verifyStateHash) {
+        std::uint64_t full = fullStateHash();
+        if (full != out) {
+            throw std::runtime_error("stateHash mismatch (incremental " + std::to_string(out) + ", full " + std::to_string(full)
+                                     + "); was a module written without touch()?");
+        }
+    }
 
+    return out;
 }
 
+void WorldBase::setJournal(Journal* j) {
+    if (typeToSystem.size() == 0) constructSystemTypemap();
+
+    if (j) {
+        for (auto& s : typeToSystem) {
+            if (!s.second.canEncodeModules()) {
+                throw std::invalid_argument("Can't journal SystemType " + std::to_string(s.first) + "; its Instances have no JournalCodec");
+            }
+        }
+    }
+
+    for (auto& s : typeToSystem) {
+        if (journal) s.second.removeObserver(journal);
+        if (j) s.second.addObserver(j);
+    }
+
+    journal = j;
+}
+
+void WorldBase::setExtractor(Extractor* x) {
+    if (typeToSystem.size() == 0) constructSystemTypemap();
+
+    for (auto& s : typeToSystem) {
+        if (extractor) s.second.removeObserver(extractor);
+        if (x) s.second.addObserver(x);
+    }
+
+    if (extractor) extractor->attached = false;
+    extractor = x;
+    if (extractor) extractor->attached = true;
+}
+
+std::size_t WorldBase::extract(void* buffer, EntityID* eids, std::size_t capacity, double alpha, ExtractMode mode) {
+    if (extractor == nullptr) throw std::runtime_error("WorldBase::extract needs an Extractor; see setExtractor");
+    if (capacity < entities.size()) {
+        throw std::invalid_argument("WorldBase::extract: room for " + std::to_string(capacity) + " records, but there are "
+                                    + std::to_string(entities.size()) + " entities");
+    }
+
+    Extractor& x = *extractor;
+    char* out = static_cast<char*>(buffer);
+    std::size_t written = 0;
+
+    auto write = [&] (Entity& e) {
+        bool moving = x.write(e, out + written * x.stride, alpha);
+        if (eids != nullptr) eids[written] = e.getID();
+        written++;
+        return moving;
+    };
+
+    //entities moving now; they're rewritten on the next Changed call too, since this call's record is mid-interpolation
+    x.scratchMoving.clear();
+
+    if (mode == ExtractMode::All) {
+        for (auto& e : entities) {
+            if (write(*e.second)) x.scratchMoving.push_back(e.first);
+        }
+    }
+    else {
+        //everything else is asleep, or was awake and still at the last call, so its record hasn't changed
+        for (Entity* e : awakeEntities) if (Extractor::isMoving(*e)) x.scratchMoving.push_back(e->getID());
+
+        x.pending.clear();
+        for (auto* list : {&x.created, &x.dirty, &x.settled, &x.moving, &x.scratchMoving}) {
+            x.pending.insert(x.pending.end(), list->begin(), list->end());
+        }
+
+        std::sort(x.pending.begin(), x.pending.end());
+        x.pending.erase(std::unique(x.pending.begin(), x.pending.end()), x.pending.end());
+
+        for (EntityID eid : x.pending) {
+            if (Entity* e = entities.get(eid)) write(*e);
+        }
+    }
+
+    std::swap(x.moving, x.scratchMoving);
+
+    x.created.clear();
+    x.dirty.clear();
+    x.settled.clear();
+    std::swap(x.removedList, x.erased);
+    x.erased.clear();
+
+    return written;
+}
+
+void WorldBase::journalFrame() {
+    //prevPos is last frame's pos, so this catches anything moved during the frame (sleeping entities don't move)
+    for (Entity* e : awakeEntities) {
+        Placement prev = e->getPrevPos();
+        if (std::memcmp(&prev, &e->pos, sizeof(Placement)) != 0) journal->entityMoved(e->getID(), e->pos);
+    }
+
+    journal->commitFrame();
+}
+
+bool WorldBase::compact(double budgetSeconds) {
+    if (typeToSystem.size() == 0) constructSystemTypemap();
+
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&] () -> double {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    //steps: world containers, each System in typeToSystem order, the TaskSystem, then releasing memory
+    std::size_t steps = typeToSystem.size() + 3;
+
+    do {
+        std::size_t step = compactionCursor++;
+
+        if (step == 0) {
+            entities.shrink();
+            ids.shrink();
+            shrinkVector(awakeEntities);
+            creationQueue.shrink();
+            shrinkVector(creating);
+            shrinkVector(deletionQueue);
+        }
+        else if (step <= typeToSystem.size()) {
+            std::next(typeToSystem.begin(), step - 1)->second.compact();
+        }
+        else if (step == typeToSystem.size() + 1) {
+            tasks.compact();
+        }
+        else {
+            releaseFreeMemory();
+            compactionCursor = 0;
+            return true;
+        }
+    } while (elapsed() < budgetSeconds && compactionCursor < steps);
+
+    return false;
+}
+
+void WorldBase::startTask(EntityID eid, Task&& t) {
+    getEntity(eid).addRelatedSystem(&tasks);
+    tasks.start(eid, std::move(t));
+}
+
+void WorldBase::setFixedStep(double step, int maxSteps, CatchUpPolicy policy) {
+    assert(step > 0. && maxSteps > 0);
+
+    fixedStep = step;
+    maxSubSteps = maxSteps;
+    catchUpPolicy = policy;
+    accumulator = std::min(accumulator, fixedStep);
+}
+
+int WorldBase::advance(double realDeltaTime) {
+    accumulator += realDeltaTime;
+
+    int steps = 0;
+    while (accumulator >= fixedStep && steps < maxSubSteps) {
+        update(fixedStep);
+        accumulator -= fixedStep;
+        steps++;
+    }
+
+    if (accumulator >= fixedStep) {
+        if (catchUpPolicy == CatchUpPolicy::Drop) accumulator = std::fmod(accumulator, fixedStep);
+        else accumulator = std::min(accumulator, fixedStep * maxSubSteps);
+    }
+
+    return steps;
+}
+
+void WorldBase::interpolatePlacements(std::vector<std::pair<EntityID, Placement>>& out, double alpha, bool useSlerp) const {
+    out.clear();
+    out.reserve(entities.size());
+
+    for (auto& e : entities) {
+        out.emplace_back(e.first, Placement::interpolate(e.second->getPrevPos(), e.second->pos, alpha, useSlerp));
+    }
+}
 
 void WorldBase::appendComponent(EntityID eid, const IPartialComponent& pc) {
     Entity& e = getEntity(eid);
@@ -144,19 +612,209 @@ void WorldBase::appendComponent(EntityID eid, std::shared_ptr<IPartialComponent>
     appendComponent(eid, *pc);
 }
 
+SystemBase& WorldBase::systemForRemoval(SystemType st) {
+    SystemBase* sys = getSystemIndirect(st);
+    if (sys == nullptr) throw std::invalid_argument("Tried to remove a component of SystemType " + std::to_string(st) + ", which this world doesn't have");
+    return *sys;
+}
+
+SystemBase& WorldBase::systemForCreation(SystemType st) {
+    SystemBase* sys = getSystemIndirect(st);
+    if (sys == nullptr) throw std::invalid_argument("Tried to create a component of SystemType " + std::to_string(st) + ", which this world doesn't have");
+    return *sys;
+}
+
+void WorldBase::removeComponent(EntityID eid, SystemType st) {
+    Entity& e = getEntity(eid);
+    SystemBase& sys = systemForRemoval(st);
+
+    //removeModule also succeeds when there was nothing to remove, which isn't worth a journal record
+    bool had = sys.hasModules(eid);
+    if (sys.removeModule(eid)) e.removeRelatedSystem(&sys);
+    if (had && journal) journal->moduleRemoved(eid, st);
+}
+
+void WorldBase::removeComponent(EntityID eid, SystemType st, ModuleID mid) {
+    Entity& e = getEntity(eid);
+    SystemBase& sys = systemForRemoval(st);
+
+    //partial removals reach the journal as a modification of the remaining modules
+    bool had = sys.hasModules(eid);
+    if (sys.removeModule(eid, mid) && had) {
+        e.removeRelatedSystem(&sys);
+        if (journal) journal->moduleRemoved(eid, st);
+    }
+}
+
+void WorldBase::removeComponents(SystemType st, const std::vector<EntityID>& eids) {
+    SystemBase& sys = systemForRemoval(st);
+
+    for (EntityID eid : eids) {
+        auto it = entities.find(eid);
+        if (it == entities.end()) continue;
+
+        bool had = sys.hasModules(eid);
+        if (sys.removeModule(eid)) it->second->removeRelatedSystem(&sys);
+        if (had && journal) journal->moduleRemoved(eid, st);
+    }
+}
+
+void WorldBase::removeComponents(SystemType st, const std::vector<std::pair<EntityID, ModuleID>>& modules) {
+    SystemBase& sys = systemForRemoval(st);
+
+    for (auto& m : modules) {
+        auto it = entities.find(m.first);
+        if (it == entities.end()) continue;
+
+        bool had = sys.hasModules(m.first);
+        if (sys.removeModule(m.first, m.second) && had) {
+            it->second->removeRelatedSystem(&sys);
+            if (journal) journal->moduleRemoved(m.first, st);
+        }
+    }
+}
+
 std::vector<SavedEntity> WorldBase::saveEntities(std::vector<EntityID> eids) {
     std::vector<SavedEntity> out;
     for (auto& e : eids) out.push_back(getEntity(e).save());
     return out;
 }
 
+WorldSnapshot WorldBase::snapshot() {
+    WorldSnapshot out;
+
+    out.placements.reserve(entities.size());
+    for (auto& e : entities) out.placements.push_back(std::make_pair(e.first, e.second->pos));
+
+    snapshotColumns(out, nullptr);
+    return out;
+}
+
+WorldSnapshot WorldBase::snapshot(const std::vector<EntityID>& eids) {
+    WorldSnapshot out;
+
+    out.placements.reserve(eids.size());
+    for (EntityID eid : eids) out.placements.push_back(std::make_pair(eid, getEntity(eid).pos));
+
+    snapshotColumns(out, &eids);
+    return out;
+}
+
+void WorldBase::snapshotColumns(WorldSnapshot& out, const std::vector<EntityID>* eids) {
+    if (typeToSystem.size() == 0) constructSystemTypemap();
+
+    for (auto& s : typeToSystem) {
+        std::unique_ptr<IModuleColumn> column = s.second.snapshotModules(eids);
+
+        if (column == nullptr || !column->recreatable()) {
+            std::unique_ptr<PartialComponentColumn> fallback = std::make_unique<PartialComponentColumn>(s.first);
+
+            for (auto& p : out.placements) {
+                if (!s.second.hasModules(p.first)) continue;
+
+                for (auto& pc : s.second.recreatePartialComponents(p.first)) {
+                    fallback->eids.push_back(p.first);
+                    fallback->components.push_back(pc);
+                }
+            }
+
+            column = std::move(fallback);
+        }
+
+        //so a snapshot loads into any World with Systems for the modules it actually holds
+        if (column->size() == 0) continue;
+        out.columns.push_back(std::move(column));
+    }
+}
+
+std::unique_ptr<AsyncSave> WorldBase::saveAsync(AsyncSave::Writer writer) {
+    return std::make_unique<AsyncSave>(snapshot(), writer);
+}
+
+std::vector<EntityID> WorldBase::loadSnapshot(const WorldSnapshot& snapshot) {
+    assert(ids.idle() && "loadSnapshot while another thread is allocating EntityIDs");
+    std::vector<EntityID> out;
+    out.reserve(snapshot.placements.size());
+
+    for (auto& p : snapshot.placements) {
+        if (entities.slotTaken(p.first)) {
+            throw std::invalid_argument("Tried to load a snapshot containing an already existing EID (or its slot)");
+        }
+        out.push_back(p.first);
+    }
+
+    insertSnapshot(snapshot, nullptr);
+    return out;
+}
+
+std::vector<EntityID> WorldBase::duplicateSnapshot(const WorldSnapshot& snapshot) {
+    std::vector<EntityID> out;
+    out.reserve(snapshot.placements.size());
+
+    std::unordered_map<EntityID, EntityID> mapping;
+    mapping.reserve(snapshot.placements.size());
+
+    for (auto& p : snapshot.placements) {
+        out.push_back(makeNewID());
+        mapping.insert(std::make_pair(p.first, out.back()));
+    }
+
+    insertSnapshot(snapshot, &mapping);
+    return out;
+}
+
+void WorldBase::insertSnapshot(const WorldSnapshot& snapshot, const std::unordered_map<EntityID, EntityID>* eidMapping) {
+    auto t2s = getTypeToSystemFunc();
+    auto target = [&] (EntityID eid) { return eidMapping ? eidMapping->at(eid) : eid; };
+
+    entities.reserve(entities.size() + snapshot.placements.size());
+    for (auto& p : snapshot.placements) {
+        EntityID eid = target(p.first);
+
+        auto inserted = entities.insert(std::make_pair(eid, std::make_unique<Entity>(eid, p.second)));
+        addAwake(*inserted.first->second);
+        if (journal) journal->entityCreated(eid, p.second);
+        if (extractor) extractor->created.push_back(eid);
+        if (eidMapping == nullptr) ids.claim(eid);
+    }
+
+    //postCreate waits until every column is in, so it sees complete entities
+    std::vector<std::pair<EntityID, SystemBase*>> created;
+    created.reserve(snapshot.moduleCount());
+
+    for (auto& c : snapshot.columns) {
+        SystemBase& sys = systemForCreation(c->getType());
+
+        if (!sys.loadColumn(*c, eidMapping)) {
+            for (std::size_t i = 0; i < c->size(); i++) {
+                std::shared_ptr<IPartialComponent> pc = c->recreatePartialComponent(i);
+
+                if (eidMapping) {
+                    std::shared_ptr<IPartialComponent> updated = pc->duplicateUpdate(*eidMapping);
+                    if (updated.get() != nullptr) pc = updated;
+                }
+
+                (*pc)(target(c->eid(i)), t2s);
+            }
+        }
+
+        for (std::size_t i = 0; i < c->size(); i++) {
+            EntityID eid = target(c->eid(i));
+            if (entities.at(eid)->addRelatedSystem(&sys)) created.push_back(std::make_pair(eid, &sys));
+        }
+    }
+
+    for (auto& c : created) c.second->postCreate(c.first);
+}
 
 EntityID WorldBase::loadEntity(const SavedEntity& e) {
     _makeEntity(e.ID, e.components, e.pos);
+    ids.claim(e.ID);
     return e.ID;
 }
 
 std::vector<EntityID> WorldBase::loadEntities(const std::vector<SavedEntity>& list) {
+    assert(ids.idle() && "loadEntities while another thread is allocating EntityIDs");
     std::vector<EntityID> out;
     for (auto& e : list) out.push_back(loadEntity(e));
     return out;
@@ -205,6 +863,45 @@ std::vector<EntityID> WorldBase::duplicateEntities(const std::vector<SavedEntity
 }
 
 SystemBase* WorldBase::getSystemIndirect(SystemType t) {
+    if (typeToSystem.size() == 0) constructSystemTypemap();
     if (!typeToSystem.count(t)) return nullptr;
     return &typeToSystem.at(t);
 }
+
+MemoryReport WorldBase::memoryReport() {
+    if (typeToSystem.size() == 0) constructSystemTypemap();
+
+    MemoryReport out("World");
+
+    std::size_t entityHeap = 0;
+    for (auto& e : entities) entityHeap += e.second->heapBytes();
+
+    out.add("entities", entities.bytes());
+    out.add("ids", ids.bytes());
+    out.add("Entity objects", entities.size()*sizeof(Entity));
+    out.add("relatedSystems", entityHeap);
+    out.add("creationQueue", creationQueue.bytes() + vectorBytes(creating));
+    out.add("deletionQueue", vectorBytes(deletionQueue));
+    out.add("awakeEntities", vectorBytes(awakeEntities));
+    out.add("typeToSystem", hashContainerBytes(typeToSystem));
+
+    for (auto& s : typeToSystem) out.children.push_back(s.second.memoryReport());
+    out.children.push_back(tasks.memoryReport());
+    out.children.push_back(eventBus.memoryReport());
+    if (stateHasher) out.children.push_back(stateHasher->memoryReport());
+    for (auto& f : frontBuffers) out.children.push_back(f.second->memoryReport());
+    if (extractor) out.children.push_back(extractor->memoryReport());
+
+    return out;
+}
+
+MemoryReport WorldBase::memoryReport(const std::vector<SavedEntity>& list) {
+    MemoryReport out("SavedEntities");
+
+    std::size_t components = 0;
+    for (auto& e : list) components += e.heapBytes();
+
+    out.add("SavedEntity objects", vectorBytes(list));
+    out.add("components", components);
+    return out;
+}
@@ -3,9 +3,20 @@
 #include <unordered_map>
 #include <vector>
 #include <memory>
+#include <queue>
+#include <algorithm>
 
 #include "component.h"
 #include "actor.h"
+#include "task.h"
+#include "eventbus.h"
+#include "prefab.h"
+#include "snapshot.h"
+#include "journal.h"
+#include "statehash.h"
+#include "entitytable.h"
+#include "frontbuffer.h"
+#include "extract.h"
 
 #include <type_traits>
 
@@ -13,6 +24,57 @@
 template <class T>
 struct ConcatWrapper;
 
+///phases of WorldBase::update, in the order they run
+enum class UpdatePhase {
+    Events,
+    Deletion,
+    Creation,
+    Transforms,
+    Tasks,
+    Custom,
+    RateGroups,
+    Journaling,
+    Publishing,
+    Compaction,
+    Count
+};
+
+///what WorldBase::advance does with time it couldn't simulate within maxSubSteps
+enum class CatchUpPolicy {
+    ///discard it; the simulation runs slower than real time while overloaded
+    Drop,
+    ///keep it (up to maxSubSteps more steps), and catch up over the next advance calls
+    Carry
+};
+
+///per-phase heap allocations of a single WorldBase::update call
+/// (all zeros unless compiled with -DWEDGE_COUNT_ALLOCATIONS)
+struct FrameAllocations {
+    AllocationStats phases[(int) UpdatePhase::Count];
+
+    const AllocationStats& operator[](UpdatePhase p) const { return phases[(int) p]; }
+
+    AllocationStats total() const {
+        AllocationStats out;
+        for (auto& p : phases) out = out + p;
+        return out;
+    }
+};
+
+
+///deadline statistics for one WorldBase rate group
+struct RateGroupStats {
+    std::size_t runs = 0;
+    ///runs that took longer than the group's budget
+    std::size_t overBudget = 0;
+    ///runs that started a full period or more late (the skipped ticks are dropped, not replayed)
+    std::size_t late = 0;
+    double totalSeconds = 0.;
+    double maxSeconds = 0.;
+
+    std::size_t deadlinesMet() const { return runs - std::min(runs, overBudget + late); }
+    double averageSeconds() const { return runs ? totalSeconds / runs : 0.; }
+};
 
 
 class WorldBase {
@@ -21,24 +83,119 @@ class WorldBase {
     ~WorldBase();
 
 
-    void update(double deltaTime);
+    void update(double deltaTime) {
+        beginFrame(deltaTime);
+        endFrame();
+    }
+    ///update split in two for pipelined frames: beginFrame simulates (Events through RateGroups), endFrame
+    /// journals, publishes FrontBuffers and compacts; ex, with a render thread reading the last published frame:
+    ///  world.beginFrame(dt);         //render thread reads frame N's FrontBuffer views meanwhile
+    ///  renderThread.waitForViews();
+    ///  world.endFrame();             //publishes frame N+1
+    ///only FrontBuffer views are safe to read during beginFrame; extract and interpolatePlacements read the live
+    /// entities and modules, so they belong on the update thread, between endFrame and the next beginFrame
+    void beginFrame(double deltaTime);
+    void endFrame();
+    ///number of endFrame calls so far; FrontBuffer views report the frame they show in these units
+    std::uint64_t frame() const { return frameCount; }
+
+    ///fixed-step driver: advance(realDeltaTime) accumulates time and runs update(step) 0-maxSubSteps times
+    void setFixedStep(double step, int maxSubSteps = 4, CatchUpPolicy policy = CatchUpPolicy::Drop);
+    ///returns the number of steps run
+    int advance(double realDeltaTime);
+    ///how far real time is between the last two steps, [0, 1]; use for render interpolation
+    ///Carry can leave several steps in the accumulator, so it's clamped to the latest step rather than extrapolating
+    double interpolationAlpha() const { return std::min(accumulator / fixedStep, 1.); }
+
+    ///blends every entity's prevPos -> pos by alpha, into out (cleared first; reuse it across frames to avoid allocation)
+    void interpolatePlacements(std::vector<std::pair<EntityID, Placement>>& out, double alpha, bool useSlerp = false) const;
+    void interpolatePlacements(std::vector<std::pair<EntityID, Placement>>& out, bool useSlerp = false) const {
+        interpolatePlacements(out, interpolationAlpha(), useSlerp);
+    }
+
+    ///writes a record per entity (see Extractor) into buffer, which must have room for capacity records, and the
+    /// entities' EIDs into eids (if not nullptr); returns the number written. Transforms are interpolated by alpha
+    /// like interpolatePlacements. Entities are read straight from the entity table, with no per-entity hashing
+    ///reads live state, so don't overlap it with beginFrame
+    ///throws std::runtime_error without an Extractor, std::invalid_argument if capacity < entityCount()
+    std::size_t extract(void* buffer, EntityID* eids, std::size_t capacity, double alpha, ExtractMode mode = ExtractMode::All);
+    std::size_t extract(void* buffer, EntityID* eids, std::size_t capacity, ExtractMode mode = ExtractMode::All) {
+        return extract(buffer, eids, capacity, interpolationAlpha(), mode);
+    }
+    ///the record layout for extract, and its change tracking from now on (nullptr detaches)
+    void setExtractor(Extractor* x);
+
+    ///runs func(secondsSinceItsLastRun) at hz from inside update (after customUpdate), at most once per update;
+    /// ex: world.addRateGroup(10., [&] (double dt) { aiSystem.update(dt); });
+    ///phase in [0, 1) offsets the group within its period, so groups of the same rate can land on different frames
+    ///budgetSeconds > 0 is the group's deadline; runs over it are counted in its stats
+    ///returns the group's index
+    std::size_t addRateGroup(double hz, std::function<void(double)> func, double budgetSeconds = 0., double phase = 0.);
+    const RateGroupStats& rateGroupStats(std::size_t group) const { return rateGroups.at(group).stats; }
+    void resetRateGroupStats();
+
+    ///incremental compaction: each update spends up to budgetSeconds shrinking containers that load spikes left
+    /// oversized, then returns freed memory to the OS once a full pass is done; 0 disables it
+    ///the budget is checked between containers, so one very large container can overrun it
+    void setCompactionBudget(double budgetSeconds) { compactionBudget = budgetSeconds; }
+    ///returns true if this call finished a full pass
+    bool compact(double budgetSeconds);
 
     void deleteEntityNextFrame(EntityID ID);
 
     ///prefer using make/deleteEntityNextGrame, to limit inter-system update order dependence
-    EntityID makeEntityNextFrame(std::vector<std::unique_ptr<IPartialComponent>>&& list);
-    EntityID makeEntityNextFrame(std::vector<std::shared_ptr<IPartialComponent>> list);
+    ///makeEntityNextFrame is safe to call from any thread, concurrently: the EntityID is allocated right away (from a
+    /// per-thread block), and the entity is created, and visible to getEntity, in the next update's Creation phase
+    EntityID makeEntityNextFrame(std::vector<std::unique_ptr<IPartialComponent>>&& list, Placement p = Placement());
+    EntityID makeEntityNextFrame(std::vector<std::shared_ptr<IPartialComponent>> list, Placement p = Placement());
 
     //probably avoid using makeEntityRefList outside of temporary debug stuff
     EntityID makeEntityRefList(const std::vector<std::reference_wrapper<IPartialComponent>>& componentList, Placement p = Placement());
     EntityID makeEntity(const std::vector<std::shared_ptr<IPartialComponent>>& componentList, Placement p = Placement());
 
+    ///throws std::invalid_argument if a component's System is missing or has the wrong Template type
+    Prefab compilePrefab(const std::vector<std::shared_ptr<IPartialComponent>>& componentList);
+    EntityID instantiate(const Prefab& prefab, Placement p = Placement());
+    std::vector<EntityID> instantiate(const Prefab& prefab, const std::vector<Placement>& placements);
+
     ///should there be an appendComponentNextFrame()?
     void appendComponent(EntityID eid, const IPartialComponent& pc);
     void appendComponent(EntityID eid, std::shared_ptr<IPartialComponent> pc);
 
+    ///removes one component from a live entity, calling the System's preRemove hook
+    /// (the ModuleID overload is for MultiSystems, and removes only that module)
+    void removeComponent(EntityID eid, SystemType st);
+    void removeComponent(EntityID eid, SystemType st, ModuleID mid);
+    ///removes st's component from every listed entity; entities that no longer exist are skipped
+    void removeComponents(SystemType st, const std::vector<EntityID>& eids);
+    ///removes each listed module of MultiSystem st (ex: a frame's expired buffs); entities that no longer exist are skipped
+    void removeComponents(SystemType st, const std::vector<std::pair<EntityID, ModuleID>>& modules);
+
     void deleteEntity(EntityID eid);
 
+    ///sleeping entities are skipped by the transform pass, by System::applyFunctionToModules (and the sliced/budgeted
+    /// versions), and by the journal's move scan, so they cost nothing per frame; their Tasks keep running
+    ///an entity wakes on wake(), when its sleepFor timer runs out, when an Event registered with wakeOnEvent names it,
+    /// or when one of its modules is created or touch()ed
+    void sleep(EntityID eid);
+    void sleepFor(EntityID eid, double seconds);
+    void wake(EntityID eid);
+    bool isAsleep(EntityID eid) { return getEntity(eid).isAsleep(); }
+    std::size_t awakeCount() const { return awakeEntities.size(); }
+    std::size_t entityCount() const { return entities.size(); }
+
+    ///wakes Event::eID for every published Event (checked at the start of each update)
+    template <class Event>
+    void wakeOnEvent();
+
+    ///runs t from the next update on, until it finishes or eid is destroyed
+    void startTask(EntityID eid, Task&& t);
+    TaskSystem& getTaskSystem() { return tasks; }
+
+    EventBus& getEventBus() { return eventBus; }
+    template <class Event>
+    EventChannel<Event>& eventChannel() { return eventBus.channel<Event>(); }
+
     ///variadic makeEntity functions:
     /// accepts shared_ptr, vector<shared_ptr>, raw ptrs of IPartialComponent
     ///note: high probability that these end up being unacceptably slow for some use cases,
@@ -46,15 +203,36 @@ class WorldBase {
     template<class ...Args>
     EntityID makeEntityNextFrame(Placement p, Args... args);
 
+    ///if every arg is an emplace<System>(...) component, modules are built in place (see EmplaceComponent)
     template<class ...Args>
-    EntityID makeEntity(Placement p, Args... args);
+    EntityID makeEntity(Placement p, Args&&... args);
 
+    ///getEntity/findEntity/hasEntity are lock-free, and safe to call from worker threads during customUpdate
+    /// (entities are only inserted and erased at frame boundaries, or by direct make/load/deleteEntity calls)
     Entity& getEntity(EntityID i);
-    bool hasEntity(EntityID i) { return entities.count(i) > 0; }
+    ///nullptr if i doesn't exist
+    Entity* findEntity(EntityID i) const { return entities.get(i); }
+    bool hasEntity(EntityID i) const { return entities.get(i) != nullptr; }
 
     ///this will always save entities in the order of the input list
     std::vector<SavedEntity> saveEntities(std::vector<EntityID> eids);
 
+    ///point-in-time copy of every Placement and every System's modules (one block copy per System)
+    /// call it between updates
+    WorldSnapshot snapshot();
+    ///the same, for only the listed entities (placements in list order); a block copy per System instead of
+    /// saveEntities' PartialComponent per module
+    WorldSnapshot snapshot(const std::vector<EntityID>& eids);
+    ///snapshots now, then converts and hands the whole world to writer on a background thread,
+    /// while this world keeps updating
+    std::unique_ptr<AsyncSave> saveAsync(AsyncSave::Writer writer);
+
+    ///system-major load: bulk-inserts each column of a snapshot (possibly from another World), then builds
+    /// Entity membership in one pass; columns a System can't take directly go through PartialComponents
+    ///throws std::invalid_argument, before changing anything, if any snapshot EID already exists here
+    ///loads claim their EIDs from the allocator, so no worker thread may make entities meanwhile (asserted)
+    std::vector<EntityID> loadSnapshot(const WorldSnapshot& snapshot);
+
 
     //load entity: copy 1-1 into this world
     // good for loading, bad for creating entities (ID collisions between strong references, maintains weak references)
@@ -65,35 +243,152 @@ class WorldBase {
     // ex: strong references remap, weak references are broken
     EntityID duplicateEntity(const SavedEntity& e);
     std::vector<EntityID> duplicateEntities(const std::vector<SavedEntity>& list);
+    ///system-major duplicateEntities: new EIDs for every snapshot entity, then one bulk insert per column
+    /// columns of rawCopyModules Systems are copied as is; other modules go through their PartialComponent's
+    /// duplicateUpdate, like duplicateEntities; returns the new EIDs in snapshot placements order
+    std::vector<EntityID> duplicateSnapshot(const WorldSnapshot& snapshot);
 
     SystemBase* getSystemIndirect(SystemType t);
 
+    ///opt-in double buffering for one of this world's Systems: returns a FrontBuffer that endFrame keeps in sync
+    /// and other threads can read from; calling it again for the same System returns the same buffer
+    ///throws std::invalid_argument if sys isn't one of this world's Systems
+    template <class Sys>
+    FrontBuffer<Sys>& doubleBuffer(Sys& sys);
+
+    ///bytes held by the world's containers, with one child report per System
+    MemoryReport memoryReport();
+    static MemoryReport memoryReport(const std::vector<SavedEntity>& list);
+
+    const FrameAllocations& lastFrameAllocations() const { return frameAllocations; }
+
+    ///order-independent checksum of every Placement and module (XOR of per-item hashes), for lockstep desync checks
+    /// and replay validation; Tasks aren't included
+    ///the first call hashes everything and starts tracking; after that a call costs O(modules created/touch()ed
+    /// since the last one + awake entities)
+    ///throws std::invalid_argument if a System's Instances have no JournalCodec (hashing goes through it)
+    std::uint64_t stateHash();
+    ///recomputes from scratch; slow, for debugging
+    std::uint64_t fullStateHash();
+    ///makes every stateHash call also run fullStateHash, throwing std::runtime_error on a mismatch
+    /// (usually a module written without touch())
+    void setStateHashVerify(bool verify) { verifyStateHash = verify; }
+
+    ///records every change from now on into j (nullptr detaches); see Journal for recovery
+    ///throws std::invalid_argument if a System's Instances have no JournalCodec
+    void setJournal(Journal* j);
+    Journal* getJournal() { return journal; }
+
     private:
-    int maxID;
+    IDAllocator ids;
 
     std::unordered_map<SystemType, SystemBase&> typeToSystem;
-    std::unordered_map<EntityID, std::vector<std::unique_ptr<IPartialComponent>>> creationQueue;
+    CreationQueue creationQueue;
+    ///reused by the Creation phase
+    std::vector<CreationQueue::Entry> creating;
     std::vector<EntityID> deletionQueue;
 
     std::function<SystemBase&(SystemType)> getTypeToSystemFunc();
+    SystemBase& systemForRemoval(SystemType st);
+    SystemBase& systemForCreation(SystemType st);
+
+    template<class ...Emplacers>
+    EntityID makeEntityEmplace(Placement p, Emplacers&&... components);
 
     std::vector<std::reference_wrapper<SystemBase>> knownSystems;
 
     //since types aren't known at ctor time (supertype created before base type), this generates typeToSystem from knownSystems
     void constructSystemTypemap();
 
+    double fixedStep;
+    double accumulator;
+    int maxSubSteps;
+    CatchUpPolicy catchUpPolicy;
+
+    TaskSystem tasks;
+    EventBus eventBus;
+
+    double compactionBudget;
+    std::size_t compactionCursor;
+
+    FrameAllocations frameAllocations;
+    void recordPhase(UpdatePhase p, AllocationStats& phaseStart);
+
+    Journal* journal;
+    void journalFrame();
+
+    Extractor* extractor;
+
+    struct RateGroup {
+        double period;
+        double budget;
+        double accumulator;
+        double sinceLastRun;
+        std::function<void(double)> func;
+        RateGroupStats stats;
+    };
+    std::vector<RateGroup> rateGroups;
+    void runRateGroups(double deltaTime);
+
+    std::vector<Entity*> awakeEntities;
+    double simTime;
+
+    std::uint64_t frameCount;
+    AllocationStats phaseStart;
+    ///never removed from their Systems' observers, since the Systems (members of the derived World) die first
+    std::vector<std::pair<SystemBase*, std::unique_ptr<IFrontBuffer>>> frontBuffers;
+
+    std::unique_ptr<StateHasher> stateHasher;
+    std::uint64_t placementsHash;
+    bool verifyStateHash;
+    void rehashPlacement(Entity& e);
+
+    struct WakeTimer {
+        double at;
+        EntityID eID;
+
+        bool operator> (const WakeTimer& other) const { return at > other.at; }
+    };
+    std::priority_queue<WakeTimer, std::vector<WakeTimer>, std::greater<WakeTimer>> wakeTimers;
+    std::vector<std::function<void()>> eventWakers;
+
+    ///wakes entities whose modules get created or touched
+    struct MutationWaker : public ModuleObserver {
+        WorldBase* world;
+
+        void moduleCreated(SystemBase& sys, EntityID eID) { world->wakeIfAsleep(eID); }
+        void moduleModified(SystemBase& sys, EntityID eID) { world->wakeIfAsleep(eID); }
+    };
+    MutationWaker mutationWaker;
+
+    void wakeIfAsleep(EntityID eid);
+    void runWakers();
+    void addAwake(Entity& e);
+    void removeAwake(Entity& e);
+    void eraseEntity(EntityID eid);
+
+    void snapshotColumns(WorldSnapshot& out, const std::vector<EntityID>* eids);
+    ///loadSnapshot/duplicateSnapshot; eidMapping gives each snapshot EID's EID here, if they differ
+    void insertSnapshot(const WorldSnapshot& snapshot, const std::unordered_map<EntityID, EntityID>* eidMapping);
+
+    friend class Journal;
+
     protected:
 
     virtual void customUpdate(double deltaTime) =0;
 
-    EntityID makeNewID() { return EntityID(maxID++); }
+    EntityID makeNewID() { return ids.allocate(); }
     void _makeEntity(EntityID ID, const std::vector<std::reference_wrapper<IPartialComponent>>& componentList, Placement p);
     void _makeEntity(EntityID ID, const std::vector<std::shared_ptr<IPartialComponent>>& componentList, Placement p);
 
+    ///takes ownership of a fully constructed Entity, then calls postCreate on its systems
+    /// (callers that dispatch postCreate themselves pass false)
+    Entity& insertEntity(std::unique_ptr<Entity>&& e, bool runPostCreate = true);
+
     std::function<Entity*(EntityID)> getIDToEntityFunc();
 
     ///maybe limit how derived types can modify this?
-    std::unordered_map<EntityID, std::unique_ptr<Entity>> entities;
+    EntityTable entities;
 };
 
 
@@ -166,12 +461,46 @@ constexpr const std::vector<std::shared_ptr<IPartialComponent>> concatenate(Args
 
 template<class ...Args>
 EntityID WorldBase::makeEntityNextFrame(Placement p, Args... args) {
-    assert(false && "makeEntityNextFrame doesn't accept Placements yet");
-    return makeEntityNextFrame(concatenate(args...));
+    return makeEntityNextFrame(concatenate(args...), p);
 }
 
 
 template<class ...Args>
-EntityID WorldBase::makeEntity(Placement p, Args... args) {
-    return makeEntity(concatenate(args...), p);
+EntityID WorldBase::makeEntity(Placement p, Args&&... args) {
+    if constexpr (sizeof...(Args) > 0 && (isEmplaceComponent<std::decay_t<Args>>::value && ...)) {
+        return makeEntityEmplace(p, std::forward<Args>(args)...);
+    }
+    else {
+        return makeEntity(concatenate(args...), p);
+    }
+}
+
+template <class Sys>
+FrontBuffer<Sys>& WorldBase::doubleBuffer(Sys& sys) {
+    if (getSystemIndirect(sys.getType()) != &sys) {
+        throw std::invalid_argument("WorldBase::doubleBuffer: System " + std::to_string(sys.getType()) + " isn't in this world");
+    }
+
+    for (auto& f : frontBuffers) if (f.first == &sys) return static_cast<FrontBuffer<Sys>&>(*f.second);
+
+    frontBuffers.emplace_back(&sys, std::make_unique<FrontBuffer<Sys>>(sys));
+    return static_cast<FrontBuffer<Sys>&>(*frontBuffers.back().second);
+}
+
+template <class Event>
+void WorldBase::wakeOnEvent() {
+    eventWakers.push_back([this] () {
+        for (const Event& e : eventChannel<Event>().events()) wakeIfAsleep(e.eID);
+    });
+}
+
+template<class ...Emplacers>
+EntityID WorldBase::makeEntityEmplace(Placement p, Emplacers&&... components) {
+    EntityID ID = makeNewID();
+    std::unique_ptr<Entity> e = std::make_unique<Entity>(ID, p);
+
+    (e->addRelatedSystem(&components.create(ID, systemForCreation(std::decay_t<Emplacers>::Type))), ...);
+
+    insertEntity(std::move(e));
+    return ID;
 }